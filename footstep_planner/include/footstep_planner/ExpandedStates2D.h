@@ -0,0 +1,137 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_EXPANDEDSTATES2D_H_
+#define FOOTSTEP_PLANNER_EXPANDEDSTATES2D_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief A set of (x,y) planning cells marked as expanded during the search
+ * (used for visualization only).
+ *
+ * The cells are stored as bits in 64x64 tiles which are allocated on demand
+ * on the first insertion into their area. The covered area is set with
+ * resize(), insertions outside of it are ignored. Marking a cell is a bit
+ * operation without hashing or (apart from the first access of a tile) any
+ * allocation.
+ */
+class ExpandedStates2D
+{
+public:
+  /// Forward iterator over the (x,y) cells set in the bitmap.
+  class const_iterator
+  {
+  public:
+    const_iterator();
+
+    const std::pair<int, int>& operator *() const { return ivCell; }
+    const std::pair<int, int>* operator ->() const { return &ivCell; }
+
+    const_iterator& operator ++();
+    const_iterator operator ++(int);
+
+    bool operator ==(const const_iterator& other) const;
+    bool operator !=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend class ExpandedStates2D;
+
+    const_iterator(const ExpandedStates2D* states, size_t tile_pos);
+
+    /// Moves on to the next set bit starting from the current position.
+    void seek();
+
+    const ExpandedStates2D* ivpStates;
+    /// Position in ExpandedStates2D::ivUsedTiles.
+    size_t ivTilePos;
+    /// Row within the current tile.
+    int ivRow;
+    /// Bits of the current row which have not been visited yet.
+    uint64_t ivBits;
+    std::pair<int, int> ivCell;
+  };
+
+  ExpandedStates2D();
+  ~ExpandedStates2D();
+
+  /**
+   * @brief Sets the area of (discretized) cells covered by the bitmap
+   * (inclusive bounds). All previously stored cells are discarded.
+   */
+  void resize(int min_x, int min_y, int max_x, int max_y);
+
+  /// @brief Marks the cell (x,y) as expanded.
+  void insert(int x, int y)
+  {
+    unsigned int ux = x - ivMinX;
+    unsigned int uy = y - ivMinY;
+    if (ux >= ivSizeX || uy >= ivSizeY)
+      return;
+
+    unsigned int tile = (uy >> cvTileShift) * ivNumTilesX + (ux >> cvTileShift);
+    uint64_t* bits = ivTiles[tile];
+    if (bits == NULL)
+      bits = allocateTile(tile);
+    bits[uy & cvTileMask] |= uint64_t(1) << (ux & cvTileMask);
+  }
+
+  /// @brief Unmarks all cells (the allocated tiles are kept for reuse).
+  void clear();
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+private:
+  static const int cvTileShift = 6;
+  static const int cvTileSize = 1 << cvTileShift;
+  static const int cvTileMask = cvTileSize - 1;
+
+  uint64_t* allocateTile(unsigned int tile);
+
+  /// Frees all allocated tiles.
+  void release();
+
+  int ivMinX;
+  int ivMinY;
+  unsigned int ivSizeX;
+  unsigned int ivSizeY;
+  unsigned int ivNumTilesX;
+
+  /// Tile index => bits of the tile (one word per row) or NULL.
+  std::vector<uint64_t*> ivTiles;
+  /// Indices of all allocated tiles, in the order of their allocation.
+  std::vector<unsigned int> ivUsedTiles;
+
+  // non-copyable
+  ExpandedStates2D(const ExpandedStates2D&);
+  ExpandedStates2D& operator =(const ExpandedStates2D&);
+};
+}
+#endif  // FOOTSTEP_PLANNER_EXPANDEDSTATES2D_H_
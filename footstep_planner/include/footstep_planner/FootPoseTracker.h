@@ -0,0 +1,125 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_FOOTPOSETRACKER_H_
+#define FOOTSTEP_PLANNER_FOOTPOSETRACKER_H_
+
+#include <footstep_planner/State.h>
+#include <ros/ros.h>
+#include <tf/transform_listener.h>
+
+#include <boost/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <string>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Tracks the robot's feet in tf and keeps the latest settled foot
+ * poses, i.e. the poses of both feet after they have not moved for a
+ * certain time, to provide the start of a planning task without waiting.
+ *
+ * The feet are sampled in a thread of their own (independent of the ROS
+ * callback processing) from the latest transforms available in tf. Only
+ * transforms newer than the previous sample count, the settle time is
+ * measured in the time stamps of the transforms.
+ */
+class FootPoseTracker
+{
+public:
+  /**
+   * @param rate Rate at which the foot poses are sampled from tf.
+   * @param settle_time Time both feet have to be at rest to be settled.
+   */
+  FootPoseTracker(const tf::TransformListener& listener,
+                  const std::string& left_foot_id,
+                  const std::string& right_foot_id,
+                  const std::string& world_frame_id,
+                  double rate, double settle_time);
+  virtual ~FootPoseTracker();
+
+  /// @brief Sets the frame of the foot poses (discards the settled poses).
+  void setWorldFrame(const std::string& world_frame_id);
+
+  /**
+   * @brief Discards the settled foot poses, e.g. after a step has been
+   * commanded (the feet then have to be at rest again after this call).
+   */
+  void invalidate();
+
+  /**
+   * @brief Gets the settled foot poses, waiting at most 'timeout' seconds
+   * for the feet to settle.
+   *
+   * @return False if the feet have not settled within the timeout.
+   */
+  bool getSettledFeet(State* left, State* right, double timeout=0.0) const;
+
+private:
+  /// @brief Main loop of the sampling thread.
+  void run();
+
+  /**
+   * @return True if the latest (recent) pose of a foot is available in tf,
+   * 'stamp' is the time of its transform.
+   */
+  bool lookupFoot(const std::string& foot_id,
+                  const std::string& world_frame_id, Leg leg, State* foot,
+                  ros::Time* stamp);
+
+  /// @return True if the foot has not moved between two samples.
+  static bool atRest(const State& last, const State& current);
+
+  /// Max. translation between two samples of a foot at rest.
+  static const double cvRestDistance;
+  /// Max. rotation between two samples of a foot at rest.
+  static const double cvRestAngle;
+  /// Max. age of a transform to be used.
+  static const double cvMaxTransformAge;
+
+  const tf::TransformListener& ivTransformListener;
+  const std::string ivIdFootLeft;
+  const std::string ivIdFootRight;
+  const double ivRate;
+  const double ivSettleTime;
+
+  /// Locks ivIdWorldFrame, the settled foot poses and ivRestSince.
+  mutable boost::mutex ivLock;
+  mutable boost::condition_variable ivSettledCondition;
+  std::string ivIdWorldFrame;
+  bool ivSettled;
+  State ivSettledLeft;
+  State ivSettledRight;
+  /// Transform time since which both feet are at rest (zero if they are not).
+  ros::Time ivRestSince;
+
+  /// Latest samples (used by the sampling thread only).
+  bool ivSampled;
+  State ivLastLeft;
+  State ivLastRight;
+  ros::Time ivLastStampLeft;
+  ros::Time ivLastStampRight;
+
+  boost::shared_ptr<boost::thread> ivThreadPtr;
+};
+}
+#endif  // FOOTSTEP_PLANNER_FOOTPOSETRACKER_H_
@@ -22,6 +22,7 @@
 #define FOOTSTEP_PLANNER_FOOTSTEPNAVIGATION_H_
 
 #include <actionlib/client/simple_action_client.h>
+#include <footstep_planner/FootPoseTracker.h>
 #include <footstep_planner/FootstepPlanner.h>
 #include <footstep_planner/State.h>
 #include <geometry_msgs/Pose.h>
@@ -38,6 +39,8 @@
 #include <tf/tf.h>
 #include <tf/transform_listener.h>
 
+#include <boost/thread/condition_variable.hpp>
+
 #include <assert.h>
 
 
@@ -50,13 +53,20 @@ namespace footstep_planner
 class FootstepNavigation
 {
 public:
-  FootstepNavigation();
+  /**
+   * @param nh NodeHandle for the map, goal, footstep services and
+   * execution.
+   * @param nh_private NodeHandle for the parameters (also of the planner)
+   * and the published information.
+   */
+  FootstepNavigation(ros::NodeHandle nh = ros::NodeHandle(),
+                     ros::NodeHandle nh_private = ros::NodeHandle("~"));
   virtual ~FootstepNavigation();
 
   /// @brief Wrapper for FootstepPlanner::setGoal.
   bool setGoal(const geometry_msgs::PoseStampedConstPtr goal_pose);
 
-  /// @brief Wrapper for FootstepPlanner::setGoal.
+  /// @brief Wrapper for FootstepPlanner::setGoal (sets the final goal).
   bool setGoal(float x, float y, float theta);
 
   /**
@@ -133,12 +143,104 @@ protected:
       const State& current_support_leg, int starting_step_num,
       std::vector<humanoid_nav_msgs::StepTarget>& footsteps);
 
-  /// @brief Updates the robot's current pose.
+  /**
+   * @brief Updates the robot's current pose. Uses the settled foot poses of
+   * the FootPoseTracker and falls back to waiting for tf if the feet do not
+   * settle within 'start_timeout'.
+   */
   bool updateStart();
 
-  /// @brief Executes footsteps as boost::thread.
+  /**
+   * @brief Executes footsteps as boost::thread. The planned footsteps of a
+   * path are checked at once when the path is taken. Each footstep is
+   * performed by a separate thread (see performFootstep()) such that the
+   * next one is prepared while the robot is walking.
+   */
   void executeFootsteps();
 
+  /**
+   * @brief Performs 'step' via the footstep service and stores the time
+   * it has been finished (runs as boost::thread).
+   */
+  void performFootstep(humanoid_nav_msgs::StepTarget step);
+
+  /// @brief Waits until the footstep currently performed (if any) is done.
+  void waitForFootstep();
+
+  /**
+   * @brief Copies the path of the planner to ivPath (i.e. the path to
+   * execute). Needs to be called with ivPlannerLock being locked.
+   */
+  void takePlannerPath();
+
+  /**
+   * @brief Requests a plan starting at the foot poses of ivPath which will
+   * be reached 'replanning_lookahead' steps after the current one (or at
+   * the end of ivPath if 'from_path_end' is set). The plan is calculated by
+   * the replanning thread while the robot keeps walking. (Does not lock
+   * ivPlannerLock, the steps are checked in ivExecutionEnvironmentPtr.)
+   *
+   * @return False if the replanning is not possible, i.e. the execution has
+   * to be stopped for replanning (the goal is too close or one of the steps
+   * until the start of the new plan is occupied).
+   */
+  bool requestReplanning(bool from_path_end=false);
+
+  /**
+   * @brief Sets 'map' in the planner, the 2D route planning and the
+   * execution environment. Needs to be called with ivPlannerLock being
+   * locked.
+   *
+   * @return True if a replanning is necessary.
+   */
+  bool updateMap(const gridmap_2d::GridMap2DConstPtr& map);
+
+  /**
+   * @brief Applies a map received during background replanning (called by
+   * the replanning thread between two plans): requests a new plan or stops
+   * the execution if the path is affected.
+   */
+  void applyMap(const nav_msgs::OccupancyGridConstPtr& occupancy_map);
+
+  /**
+   * @brief Sets the goal of the planner for the current start: the final
+   * goal or, in receding horizon mode, the pose 'planning_horizon' meters
+   * ahead on the 2D path to the final goal. Needs to be called with
+   * ivPlannerLock being locked.
+   *
+   * @return False if no goal could be set.
+   */
+  bool updatePlanningGoal();
+
+  /**
+   * @brief Local repair of ivPath after the robot deviated from it:
+   * searches a sequence of at most 'repair_max_steps' footsteps from the
+   * actual support foot to one of the states of ivPath following
+   * 'first_idx'. On success ivPath is replaced by the support foot, the
+   * found footsteps and the rest of ivPath. The search runs in
+   * ivExecutionEnvironmentPtr, i.e. it does not wait for the planner.
+   *
+   * @return False if the path cannot be repaired (i.e. replanning is
+   * necessary).
+   */
+  bool repairPath(const State& support_foot, size_t first_idx);
+
+  /**
+   * @brief Main loop of the replanning thread: calculates the requested
+   * plans and applies the maps received in between (see applyMap()).
+   */
+  void replanningLoop();
+
+  /**
+   * @brief Called by the execution thread at each step boundary: switches
+   * to a plan calculated in the background if it starts at the current
+   * support foot 'step_idx' (index in ivPath, reset to 0 on a switch).
+   *
+   * @return False if the plan calculated in the background was too late and
+   * a new one could not be requested.
+   */
+  bool switchToReplannedPath(size_t* step_idx);
+
   /**
   * @brief Alternative (and more fluid) execution of footsteps using
   * ROS' actionlib.
@@ -187,6 +289,29 @@ protected:
                         float b_x, float b_y, float b_theta);
 
   FootstepPlanner ivPlanner;
+  /// Locks the access to ivPlanner (shared with the replanning thread).
+  boost::mutex ivPlannerLock;
+
+  /**
+   * Environment with the planner's map for the checks and the path repair
+   * of the execution thread, which must not wait for a plan calculated in
+   * the background.
+   */
+  boost::shared_ptr<FootstepPlannerEnvironment> ivExecutionEnvironmentPtr;
+  /// Locks the access to ivExecutionEnvironmentPtr.
+  boost::mutex ivExecutionEnvironmentLock;
+
+  /// Map received during background replanning, not applied yet.
+  nav_msgs::OccupancyGridConstPtr ivPendingMap;
+  /// Locks ivPendingMap.
+  boost::mutex ivPendingMapLock;
+
+  /**
+   * The path currently executed. A copy of the planner's path since the
+   * planner may calculate a new path in the background during the
+   * execution.
+   */
+  std::vector<State> ivPath;
 
   ros::Subscriber ivGridMapSub;
   ros::Subscriber ivRobotPoseSub;
@@ -197,9 +322,18 @@ protected:
 
   tf::TransformListener ivTransformListener;
 
+  /// Provides the settled foot poses as start of the planning.
+  boost::shared_ptr<FootPoseTracker> ivFootPoseTrackerPtr;
+  /// Max. time to wait for the feet to settle before falling back to tf.
+  double ivStartTimeout;
+
   boost::mutex ivExecutionLock;
 
   boost::shared_ptr<boost::thread> ivFootstepExecutionPtr;
+  /// The thread performing the current footstep (see performFootstep()).
+  boost::shared_ptr<boost::thread> ivStepThreadPtr;
+  /// Time the last footstep has been finished.
+  ros::Time ivStepFinishedTime;
 
   std::string ivIdFootRight;
   std::string ivIdFootLeft;
@@ -242,6 +376,62 @@ protected:
   /// Whether to use the slower but more cautious execution or not.
   bool ivSafeExecution;
 
+  /**
+   * Whether to replan in a background thread on map updates while the
+   * robot keeps walking (requires the safe execution).
+   */
+  bool ivBackgroundReplanning;
+  /// Number of steps ahead of the current one from which to replan.
+  int ivReplanningLookahead;
+
+  boost::shared_ptr<boost::thread> ivReplanningThreadPtr;
+  /**
+   * Locks the replanning request, the plan calculated in the background,
+   * ivExecutionStepIdx and modifications of ivPath during the execution.
+   */
+  boost::mutex ivReplanningLock;
+  boost::condition_variable ivReplanningCondition;
+  bool ivReplanningRequested;
+  /// Set if the requested plan could not be calculated.
+  bool ivReplanningFailed;
+  /// Index in ivPath of the support foot at which the requested plan starts.
+  size_t ivReplanningStepIdx;
+  State ivReplanningStartLeft;
+  State ivReplanningStartRight;
+  /// Plan calculated in the background (empty if there is none).
+  std::vector<State> ivReplannedPath;
+  /// Index in ivPath of the support foot at which ivReplannedPath starts.
+  size_t ivReplannedStepIdx;
+  /// Index in ivPath of the current support foot during the execution.
+  size_t ivExecutionStepIdx;
+  /// Incremented whenever ivPath is replaced or repaired.
+  unsigned int ivPathRevision;
+  /// Revision of ivPath the requested plan refers to.
+  unsigned int ivReplanningRevision;
+
+  /**
+   * Max. number of footsteps to reconnect to the path after a deviation
+   * (see repairPath()); 0 always replans.
+   */
+  int ivRepairMaxSteps;
+
+  /**
+   * Max. length of the 2D path to the final goal covered by a footstep plan
+   * (receding horizon mode), the path is extended as the robot walks. If 0,
+   * footsteps are planned to the final goal at once.
+   */
+  double ivPlanningHorizon;
+  /// The final goal of the navigation task (robot pose).
+  State ivFinalGoal;
+  /// True if the goal of the planner is the final goal.
+  bool ivFinalGoalPlanned;
+  /// True if ivPath ends at the final goal.
+  bool ivPathReachesGoal;
+  /// True if ivReplannedPath ends at the final goal.
+  bool ivReplannedPathReachesGoal;
+  /// Used to calculate the 2D path to the final goal.
+  boost::shared_ptr<PathCostHeuristic> ivRouteHeuristicPtr;
+
   double ivMaxStepX;
   double ivMaxStepY;
   double ivMaxStepTheta;
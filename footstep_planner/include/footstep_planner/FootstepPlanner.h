@@ -22,14 +22,21 @@
 #ifndef FOOTSTEP_PLANNER_FOOTSTEPPLANNER_H_
 #define FOOTSTEP_PLANNER_FOOTSTEPPLANNER_H_
 
+#include <actionlib/server/simple_action_server.h>
+#include <boost/thread/mutex.hpp>
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <gridmap_2d/GridMap2DCache.h>
 #include <humanoid_nav_msgs/PlanFootsteps.h>
 #include <humanoid_nav_msgs/PlanFootstepsBetweenFeet.h>
+#include <map_msgs/OccupancyGridUpdate.h>
 #include <footstep_planner/helper.h>
 #include <footstep_planner/PathCostHeuristic.h>
 #include <footstep_planner/FootstepPlannerEnvironment.h>
+#include <footstep_planner/NativeARAPlanner.h>
+#include <footstep_planner/NativeRStarPlanner.h>
+#include <footstep_planner/PlanFootstepsAnytimeAction.h>
 #include <footstep_planner/PlanningStateChangeQuery.h>
 #include <footstep_planner/State.h>
 #include <nav_msgs/Path.h>
@@ -49,6 +56,8 @@
 namespace footstep_planner
 {
 typedef std::vector<State>::const_iterator state_iter_t;
+typedef actionlib::SimpleActionServer<PlanFootstepsAnytimeAction>
+    PlanFootstepsAnytimeServer;
 
 /**
  * @brief A class to control the interaction between ROS and the footstep
@@ -57,7 +66,11 @@ typedef std::vector<State>::const_iterator state_iter_t;
 class FootstepPlanner
 {
 public:
-  FootstepPlanner();
+  /**
+   * @param nh_private NodeHandle for the parameters and the published
+   * (debug) information (the node's private namespace by default).
+   */
+  FootstepPlanner(ros::NodeHandle nh_private = ros::NodeHandle("~"));
   virtual ~FootstepPlanner();
 
   /**
@@ -94,6 +107,15 @@ public:
   bool planFeetService(humanoid_nav_msgs::PlanFootstepsBetweenFeet::Request &req,
                    humanoid_nav_msgs::PlanFootstepsBetweenFeet::Response &resp);
 
+  /**
+   * @brief Action handle to plan footsteps (executed in the thread of the
+   * action server). With the NativeARAPlanner each improved path is
+   * published as feedback, a preemption stops the search and returns the
+   * best path found so far.
+   */
+  void planAnytimeAction(PlanFootstepsAnytimeServer* server,
+                         const PlanFootstepsAnytimeGoalConstPtr& goal);
+
   /**
    * @brief Sets the goal pose as two feet (left / right)
    *
@@ -137,12 +159,14 @@ public:
   bool setStart(const State& left_foot, const State& right_foot);
 
   /**
-   * @brief Updates the map in the planning environment.
+   * @brief Updates the map in the planning environment. A map with another
+   * distance map depth than configured (parameter distance_map_depth) is
+   * converted in an own copy, see getMap().
    *
    * @return True if a replanning is necessary, i.e. the old path is not valid
    * any more.
    */
-  bool updateMap(const gridmap_2d::GridMap2DPtr map);
+  bool updateMap(const gridmap_2d::GridMap2DConstPtr map);
 
   void setMarkerNamespace(const std::string& ns)
   {
@@ -185,6 +209,14 @@ public:
    */
   void mapCallback(const nav_msgs::OccupancyGridConstPtr& occupancy_map);
 
+  /**
+   * @brief Callback to patch the current map (see
+   * gridmap_2d::GridMap2D::applyUpdate), ignored before the first map.
+   *
+   * Subscribed to 'map_updates'.
+   */
+  void mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& map_update);
+
   /**
    * @brief Clear the footstep path visualization from a previous planning
    * task.
@@ -209,6 +241,12 @@ public:
   /// @return Size of the planned path.
   int getPathSize() { return ivPath.size(); }
 
+  /**
+   * @return The map used for planning (not thread-safe, see
+   * ivPlanningMutex; it is patched in place by mapUpdateCallback()).
+   */
+  const gridmap_2d::GridMap2DConstPtr& getMap() const { return ivMapPtr; }
+
   State getStartFootLeft() { return ivStartFootLeft; }
   State getStartFootRight() { return ivStartFootRight; }
 
@@ -234,6 +272,13 @@ protected:
   /// helper to create service response
   void extractFootstepsSrv(std::vector<humanoid_nav_msgs::StepTarget> & footsteps) const;
 
+  /// @brief Publishes an intermediate solution of the anytime search.
+  void intermediateSolutionCallback(const std::vector<int>& state_ids,
+                                    int cost, double eps);
+
+  /// @return True if the running planning action is to be stopped.
+  bool planningPreempted();
+
   /**
    * @return True if the newly calculated path is different from the existing
    * one (if one exists).
@@ -265,10 +310,16 @@ protected:
   void setPlanner();
 
   /// @brief Updates the environment in case of a changed map.
-  void updateEnvironment(const gridmap_2d::GridMap2DPtr old_map);
+  void updateEnvironment(const gridmap_2d::GridMap2DConstPtr old_map);
 
   boost::shared_ptr<FootstepPlannerEnvironment> ivPlannerEnvironmentPtr;
-  gridmap_2d::GridMap2DPtr ivMapPtr;
+  /// Environments of the parallel local searches of the NativeRStarPlanner.
+  std::vector<boost::shared_ptr<FootstepPlannerEnvironment> >
+      ivWorkerEnvironments;
+  gridmap_2d::GridMap2DConstPtr ivMapPtr;
+  /// Own copy of the map after the first map update, patched in place by
+  /// mapUpdateCallback() as long as it is ivMapPtr.
+  gridmap_2d::GridMap2DPtr ivPatchedMapPtr;
   boost::shared_ptr<SBPLPlanner> ivPlannerPtr;
 
   boost::shared_ptr<const PathCostHeuristic> ivPathCostHeuristicPtr;
@@ -290,6 +341,15 @@ protected:
   ros::ServiceServer ivFootstepPlanService;
   ros::ServiceServer ivFootstepPlanFeetService;
 
+  /// Server of the currently running planning action (or NULL).
+  PlanFootstepsAnytimeServer* ivPlanAnytimeServer;
+  ros::WallTime ivPlanningStartTime;
+  /**
+   * Serializes the planning requests (the action is executed in a thread
+   * of its own).
+   */
+  boost::mutex ivPlanningMutex;
+
   double ivFootSeparation;
   double ivMaxStepWidth;
   int    ivCollisionCheckAccuracy;
@@ -307,7 +367,14 @@ protected:
    */
    int ivChangedCellsLimit;
 
+  /// Depth of the distance map (CV_32F, CV_16U or CV_8U).
+  int ivDistanceMapDepth;
+  /// Saturation (in m) of a quantized distance map.
+  double ivDistanceMapMaxDistance;
+
   std::string ivPlannerType;
+  /// Open list of the native planners (BucketQueue or DAryHeap).
+  std::string ivOpenListType;
   std::string ivMarkerNamespace;
 
   std::vector<int> ivPlanningStatesIds;
@@ -22,18 +22,19 @@
 #define FOOTSTEP_PLANNER_FOOTSTEPPLANNERENVIRONMENT_H_
 
 #include <footstep_planner/helper.h>
+#include <footstep_planner/ExpandedStates2D.h>
 #include <footstep_planner/PathCostHeuristic.h>
 #include <footstep_planner/Heuristic.h>
 #include <footstep_planner/Footstep.h>
+#include <footstep_planner/FootstepPrimitives.h>
 #include <footstep_planner/PlanningState.h>
 #include <footstep_planner/State.h>
 #include <humanoid_nav_msgs/ClipFootstep.h>
 #include <sbpl/headers.h>
 
+#include <boost/random/mersenne_twister.hpp>
 #include <math.h>
 #include <vector>
-#include <tr1/unordered_set>
-#include <tr1/hashtable.h>
 
 
 namespace footstep_planner
@@ -60,6 +61,7 @@ struct environment_params
   double max_step_width;
   int    num_random_nodes;
   double random_node_distance;
+  int    random_seed;
   double heuristic_scale;
 };
 
@@ -74,18 +76,9 @@ struct environment_params
 class FootstepPlannerEnvironment : public DiscreteSpaceInformation
 {
 public:
-  // specialization of hash<int,int>, similar to standard boost::hash on pairs?
-  struct IntPairHash{
-  public:
-    size_t operator()(std::pair<int, int> x) const throw() {
-      size_t seed = std::tr1::hash<int>()(x.first);
-      return std::tr1::hash<int>()(x.second) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-    }
-  };
-
   typedef std::vector<int> exp_states_t;
   typedef exp_states_t::const_iterator exp_states_iter_t;
-  typedef std::tr1::unordered_set<std::pair<int,int>, IntPairHash > exp_states_2d_t;
+  typedef ExpandedStates2D exp_states_2d_t;
   typedef exp_states_2d_t::const_iterator exp_states_2d_iter_t;
 
   /**
@@ -121,6 +114,7 @@ public:
    * robot orientations.
    * @param forward_search Whether to use forward search (1) or backward
    * search (0).
+   * @param random_seed Seed for the random intermediate states of R*.
    */
   FootstepPlannerEnvironment(const environment_params& params);
 
@@ -142,7 +136,7 @@ public:
   std::pair<int, int> updateStart(const State& foot_left,
                                   const State& right_right);
 
-  void updateMap(gridmap_2d::GridMap2DPtr map);
+  void updateMap(gridmap_2d::GridMap2DConstPtr map);
 
   /**
    * @return True iff the foot in State s is colliding with an
@@ -163,6 +157,27 @@ public:
    */
   void reset();
 
+  /**
+   * @brief Resets the environment to the map and the start and goal states
+   * of 'other', an environment with the same parameters. (Used for the
+   * worker environments of the NativeRStarPlanner which only serve
+   * GetSuccsTo(), the heuristic is left to 'other'.)
+   */
+  void resetTo(const FootstepPlannerEnvironment& other);
+
+  /**
+   * @return The ID of the planning state equal to the state 'id' of 'other'
+   * (an environment with the same parameters), the state is created if it
+   * does not exist yet.
+   */
+  int importState(const FootstepPlannerEnvironment& other, int id);
+
+  /**
+   * @brief Adds the expanded states of 'other' to the ones of this
+   * environment and clears them in 'other'.
+   */
+  void mergeExpandedStates(FootstepPlannerEnvironment& other);
+
   /// @return The number of expanded states during the search.
   int getNumExpandedStates() { return ivNumExpandedStates; }
 
@@ -267,6 +282,24 @@ public:
    */
   bool reachable(const PlanningState& from, const PlanningState& to);
 
+  /**
+   * @brief Local repair of a path after a deviation from it: searches the
+   * shortest sequence of at most 'max_steps' collision free footsteps
+   * from 'support_foot' to one of the states
+   * path[first_idx .. first_idx + max_steps]: footsteps of the footstep
+   * set followed by the reconnecting step, an arbitrary performable one
+   * (counted in 'max_steps'). Among the shortest sequences the one
+   * reconnecting the furthest along the path is chosen.
+   *
+   * @param repair The footsteps of the sequence (excluding 'support_foot'
+   * and the reconnecting path state).
+   *
+   * @return The index of the path state reconnected to or -1 if there is
+   * no such sequence.
+   */
+  int repairPath(const State& support_foot, const std::vector<State>& path,
+                 size_t first_idx, int max_steps, std::vector<State>* repair);
+
   void getPredsOfGridCells(const std::vector<State>& changed_states,
                            std::vector<int>* pred_ids);
 
@@ -305,6 +338,9 @@ protected:
 
   void setStateArea(const PlanningState& left, const PlanningState& right);
 
+  /// @brief Sets the map used for the collision checks (not the heuristic).
+  void setMap(gridmap_2d::GridMap2DConstPtr map);
+
   /// Wrapper for FootstepPlannerEnvironment::createNewHashEntry(PlanningState).
   const PlanningState* createNewHashEntry(const State& s);
 
@@ -380,6 +416,11 @@ protected:
   /// The set of footsteps used for the path planning.
   const std::vector<Footstep>& ivFootstepSet;
 
+  /// The footstep set compiled for the successors of a state.
+  FootstepPrimitives ivSuccessorPrimitives;
+  /// The footstep set compiled for the predecessors of a state.
+  FootstepPrimitives ivPredecessorPrimitives;
+
   /// The heuristic function used by the planner.
   const boost::shared_ptr<Heuristic> ivHeuristicConstPtr;
 
@@ -440,6 +481,14 @@ protected:
   const int ivNumRandomNodes;
   /// distance of random neighbors for R* (discretized in cells)
   const int ivRandomNodeDist;
+  /// seed of ivRandomGenerator, restored on each reset()
+  const int ivRandomSeed;
+  /**
+   * Generator for the random neighbors of R*. Each environment has its own
+   * generator so that the random states of a planning task only depend on
+   * the seed (and not on other users of rand()).
+   */
+  boost::mt19937 ivRandomGenerator;
 
   /**
    * Scaling factor of heuristic, in case it underestimates by a constant
@@ -451,8 +500,11 @@ protected:
   bool ivHeuristicExpired;
 
   /// Pointer to the map.
-  boost::shared_ptr<gridmap_2d::GridMap2D> ivMapPtr;
+  gridmap_2d::GridMap2DConstPtr ivMapPtr;
+  /// Fast access to ivMapPtr for the collision checks.
+  gridmap_2d::GridMap2DView ivMapView;
 
+  /// (x,y) cells of the expanded states, sized to the map (visualization).
   exp_states_2d_t ivExpandedStates;
   exp_states_t ivRandomStates;  ///< random intermediate states for R*
   size_t ivNumExpandedStates;
@@ -23,6 +23,9 @@
 
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <boost/scoped_ptr.hpp>
 
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
@@ -38,19 +41,36 @@ namespace footstep_planner
 class FootstepPlannerNode
 {
 public:
-  FootstepPlannerNode();
+  /**
+   * @param nh NodeHandle for the topics, services and the action.
+   * @param nh_private NodeHandle for the parameters of the planner.
+   */
+  FootstepPlannerNode(ros::NodeHandle nh = ros::NodeHandle(),
+                      ros::NodeHandle nh_private = ros::NodeHandle("~"));
   virtual ~FootstepPlannerNode();
 
 protected:
+  /// @brief Execute callback of the 'plan_footsteps_anytime' action.
+  void planAnytimeCallback(const PlanFootstepsAnytimeGoalConstPtr& goal);
+
   FootstepPlanner ivFootstepPlanner;
 
   ros::Subscriber ivGoalPoseSub;
   ros::Subscriber ivGridMapSub;
+  ros::Subscriber ivGridMapUpdateSub;
   ros::Subscriber ivStartPoseSub;
   ros::Subscriber ivRobotPoseSub;
 
   ros::ServiceServer ivFootstepPlanService;
   ros::ServiceServer ivFootstepPlanFeetService;
+
+  /**
+   * The action server uses a callback queue of its own, so that preemption
+   * requests are received while the other callbacks wait for the planner.
+   */
+  ros::CallbackQueue ivActionQueue;
+  boost::scoped_ptr<ros::AsyncSpinner> ivActionSpinner;
+  boost::scoped_ptr<PlanFootstepsAnytimeServer> ivPlanAnytimeServer;
 };
 }
 #endif  // FOOTSTEP_PLANNER_FOOTSTEPPLANNERNODE_H_
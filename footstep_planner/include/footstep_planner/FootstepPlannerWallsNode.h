@@ -0,0 +1,75 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_FOOTSTEPPLANNERWALLSNODE_H_
+#define FOOTSTEP_PLANNER_FOOTSTEPPLANNERWALLSNODE_H_
+
+
+#include <ros/ros.h>
+
+#include <footstep_planner/FootstepPlanner.h>
+#include <gridmap_2d/GridMap2D.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+#include <nav_msgs/OccupancyGrid.h>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Wrapper class for FootstepPlanner, providing callbacks for
+ * the node functionality. This node additionally sets wall regions
+ * for the footstep planner, from a dedicated map callback.
+ *
+ */
+class FootstepPlannerWallsNode
+{
+public:
+  /**
+   * @param nh NodeHandle for the topics and services.
+   * @param nh_private NodeHandle for the parameters.
+   */
+  FootstepPlannerWallsNode(ros::NodeHandle nh = ros::NodeHandle(),
+                           ros::NodeHandle nh_private = ros::NodeHandle("~"));
+  virtual ~FootstepPlannerWallsNode();
+
+  void mapCallback(const nav_msgs::OccupancyGridConstPtr& occupancyMap);
+  void wallMapCallback(const nav_msgs::OccupancyGridConstPtr& occupancyMap);
+  /// @brief Patches the obstacle map and the combined map from 'map_updates'.
+  void mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& mapUpdate);
+
+protected:
+  ros::NodeHandle ivNh;
+  footstep_planner::FootstepPlanner ivFootstepPlanner;
+  /// The obstacle map (shared, see gridmap_2d::GridMap2DCache).
+  gridmap_2d::GridMap2DConstPtr ivGridMap;
+  /// Own copy of the obstacle map after the first map update, patched in
+  /// place as long as it is ivGridMap.
+  gridmap_2d::GridMap2DPtr ivPatchedGridMap;
+  /// The wall map (shared, see gridmap_2d::GridMap2DCache).
+  gridmap_2d::GridMap2DConstPtr ivWallMap;
+  /// The obstacle map combined with the inflated walls, used for planning
+  /// (own copy, updated in place).
+  gridmap_2d::GridMap2DPtr ivCombinedMap;
+  double ivFootstepWallDist;
+  ros::Subscriber ivGoalPoseSub, ivGridMapSub, ivGridMapUpdateSub, ivWallMapSub, ivStartPoseSub, ivRobotPoseSub;
+  ros::ServiceServer ivFootstepPlanService;
+};
+}
+#endif  // FOOTSTEP_PLANNER_FOOTSTEPPLANNERWALLSNODE_H_
@@ -0,0 +1,101 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_FOOTSTEPPRIMITIVES_H_
+#define FOOTSTEP_PLANNER_FOOTSTEPPRIMITIVES_H_
+
+#include <footstep_planner/Footstep.h>
+#include <footstep_planner/helper.h>
+
+#include <stddef.h>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief The footstep set compiled into one contiguous table of discretized
+ * steps, indexed by [supporting leg][orientation bin][footstep].
+ *
+ * Each entry holds the translation, the resulting orientation and the step
+ * cost of one footstep performed (or reversed) on a state with the given leg
+ * and orientation, so that expanding a state is a linear pass over one row
+ * of the table instead of a lookup in the vectors of every Footstep.
+ */
+class FootstepPrimitives
+{
+public:
+  /// A footstep discretized for one supporting leg and orientation.
+  struct Primitive
+  {
+    /// The (discretized) translation in x direction.
+    int dx;
+    /// The (discretized) translation in y direction.
+    int dy;
+    /// The (discretized) orientation of the resulting state.
+    int theta;
+    /// The costs of the step (see FootstepPlannerEnvironment::stepCost).
+    int cost;
+  };
+
+  FootstepPrimitives();
+  ~FootstepPrimitives();
+
+  /**
+   * @brief Compiles the table from the footstep set.
+   *
+   * @param footstep_set The footsteps in the order of the table.
+   * @param reverse Whether the footsteps are reversed (predecessors)
+   * instead of performed (successors).
+   * @param num_angle_bins The number of orientation bins (see
+   * PlanningState).
+   * @param max_hash_size The maximal hash size.
+   * @param cell_size The size of a cell (in m).
+   * @param mm_scale The scale of the costs per m.
+   * @param step_cost The constant costs of each step (already scaled).
+   */
+  void compile(const std::vector<Footstep>& footstep_set, bool reverse,
+               int num_angle_bins, int max_hash_size,
+               double cell_size, int mm_scale, int step_cost);
+
+  /// @return The first step for a state with leg 'leg' and orientation 'theta'.
+  const Primitive* begin(Leg leg, int theta) const
+  {
+    return &ivPrimitives[(leg * ivNumAngleBins + theta) * ivNumSteps];
+  }
+
+  /// @return Past the last step for a state with leg 'leg' and orientation 'theta'.
+  const Primitive* end(Leg leg, int theta) const
+  {
+    return begin(leg, theta) + ivNumSteps;
+  }
+
+  /// @return The number of steps per state.
+  size_t size() const { return ivNumSteps; }
+
+private:
+  int ivNumAngleBins;
+  size_t ivNumSteps;
+
+  /// The steps of all legs and orientations, see begin().
+  std::vector<Primitive> ivPrimitives;
+};
+}
+#endif  // FOOTSTEP_PLANNER_FOOTSTEPPRIMITIVES_H_
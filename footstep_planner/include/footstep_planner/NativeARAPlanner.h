@@ -0,0 +1,436 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_NATIVEARAPLANNER_H_
+#define FOOTSTEP_PLANNER_NATIVEARAPLANNER_H_
+
+#include <boost/function.hpp>
+#include <footstep_planner/OpenList.h>
+#include <ros/ros.h>
+#include <sbpl/headers.h>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Interface of the native planners (NativeARAPlanner,
+ * NativeRStarPlanner) independent of their template arguments: hooks to
+ * observe the anytime search while it is running.
+ */
+class NativeARAPlannerBase : public SBPLPlanner
+{
+public:
+  /**
+   * Called with the state IDs, the cost and the epsilon of every solution
+   * found by the search (from within replan()).
+   */
+  typedef boost::function<void (const std::vector<int>&, int, double)>
+      SolutionCallback;
+  /**
+   * Polled during the search, returning true stops the search (replan()
+   * then returns the best solution found so far).
+   */
+  typedef boost::function<bool ()> StopCondition;
+
+  virtual ~NativeARAPlannerBase() {}
+
+  void setSolutionCallback(const SolutionCallback& callback)
+  {
+    ivSolutionCallback = callback;
+  }
+
+  void setStopCondition(const StopCondition& condition)
+  {
+    ivStopCondition = condition;
+  }
+
+protected:
+  bool stopRequested() const { return ivStopCondition && ivStopCondition(); }
+
+  SolutionCallback ivSolutionCallback;
+  StopCondition ivStopCondition;
+};
+
+
+/**
+ * @brief An anytime repairing A* (ARA*) search working directly on a
+ * planning environment, without SBPL's per-state CMDPSTATE structures.
+ *
+ * The search data of all states is kept in a flat table indexed by the
+ * environment's state IDs. The environment's successors / predecessors are
+ * called with a qualified (i.e. statically bound) call on the concrete
+ * Environment type, so they can be inlined. The open list is a template
+ * parameter (see OpenList.h).
+ *
+ * The planner implements the SBPLPlanner interface so that it can be used
+ * in place of SBPL's ARAPlanner. Each call of replan() starts a new search.
+ * Intermediate solutions can be observed and the search can be stopped via
+ * the hooks of NativeARAPlannerBase.
+ */
+template <class Environment, class OpenList>
+class NativeARAPlanner : public NativeARAPlannerBase
+{
+public:
+  NativeARAPlanner(Environment* environment, bool forward_search)
+  : ivEnvironment(environment),
+    ivForwardSearch(forward_search),
+    ivSearchUntilFirstSolution(false),
+    ivStartId(-1),
+    ivGoalId(-1),
+    ivInitialEps(3.0),
+    ivEpsDecrement(0.2),
+    ivEps(3.0),
+    ivSolutionEps(-1.0),
+    ivNumExpands(0),
+    ivSearchId(0),
+    ivIteration(0)
+  {
+    environment_ = environment;
+  }
+
+  virtual ~NativeARAPlanner() {}
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V)
+  {
+    int solcost;
+    return replan(allocated_time_sec, solution_stateIDs_V, &solcost);
+  }
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V, int* solcost);
+
+  virtual int set_goal(int goal_stateID)
+  {
+    ivGoalId = goal_stateID;
+    return 1;
+  }
+
+  virtual int set_start(int start_stateID)
+  {
+    ivStartId = start_stateID;
+    return 1;
+  }
+
+  virtual int force_planning_from_scratch()
+  {
+    ivStates.clear();
+    return 1;
+  }
+
+  virtual int set_search_mode(bool bSearchUntilFirstSolution)
+  {
+    ivSearchUntilFirstSolution = bSearchUntilFirstSolution;
+    return 1;
+  }
+
+  /// Each replan() starts a new search, so changed costs need no handling.
+  virtual void costs_changed(StateChangeQuery const& stateChange) {}
+
+  virtual double get_solution_eps() const { return ivSolutionEps; }
+  virtual int get_n_expands() const { return ivNumExpands; }
+  virtual void set_initialsolution_eps(double initialsolution_eps)
+  {
+    ivInitialEps = initialsolution_eps;
+  }
+  virtual double get_initial_eps() { return ivInitialEps; }
+  virtual double get_final_epsilon() { return ivSolutionEps; }
+
+protected:
+  enum SearchResult { SOLVED, EXHAUSTED, INTERRUPTED };
+
+  /// Search data of a single planning state.
+  struct SearchState
+  {
+    SearchState()
+    : g(INFINITECOST), h(0), bp(-1), closed(0), incons(0), search_id(0)
+    {}
+
+    int g;
+    int h;
+    /// back pointer (ID of the state this one was reached from)
+    int bp;
+    /// search iteration in which the state was expanded
+    unsigned int closed;
+    /// search iteration in which the state was put into ivIncons
+    unsigned int incons;
+    /// search in which the data was initialized (lazy reset)
+    unsigned int search_id;
+  };
+
+  /**
+   * @return The search data of state 'id', (re)initialized for the current
+   * search if necessary. Note that the reference gets invalid if the table
+   * grows, i.e. when a new state is accessed.
+   */
+  SearchState& getSearchState(int id)
+  {
+    if ((size_t)id >= ivStates.size())
+      ivStates.resize(std::max(size_t(id + 1), 2 * ivStates.size()));
+
+    SearchState& s = ivStates[id];
+    if (s.search_id != ivSearchId)
+    {
+      s.g = INFINITECOST;
+      s.bp = -1;
+      s.closed = 0;
+      s.incons = 0;
+      s.search_id = ivSearchId;
+      if (ivForwardSearch)
+        s.h = ivEnvironment->Environment::GetGoalHeuristic(id);
+      else
+        s.h = ivEnvironment->Environment::GetStartHeuristic(id);
+    }
+    return s;
+  }
+
+  int key(const SearchState& s) const
+  {
+    return s.g + int(ivEps * s.h);
+  }
+
+  /**
+   * @brief Expands states until the goal cannot be improved any more, the
+   * time is up (unless ignore_deadline) or a stop is requested.
+   */
+  SearchResult improvePath(int search_goal, const ros::WallTime& deadline,
+                           bool ignore_deadline);
+
+  /**
+   * @brief Reinserts the open and inconsistent states with their keys for
+   * the current (decreased) epsilon.
+   */
+  void reorderOpen();
+
+  /// @brief Follows the back pointers from the goal of the search.
+  bool extractPath(int search_start, int search_goal,
+                   std::vector<int>* solution) const;
+
+  Environment* ivEnvironment;
+  bool ivForwardSearch;
+  bool ivSearchUntilFirstSolution;
+
+  int ivStartId;
+  int ivGoalId;
+
+  double ivInitialEps;
+  double ivEpsDecrement;
+  double ivEps;
+  double ivSolutionEps;
+  int ivNumExpands;
+
+  unsigned int ivSearchId;
+  unsigned int ivIteration;
+
+  /// State ID => search data.
+  std::vector<SearchState> ivStates;
+  OpenList ivOpen;
+  std::vector<int> ivIncons;
+
+  /// Buffers for the successors / predecessors of the expanded state.
+  std::vector<int> ivNeighborIds;
+  std::vector<int> ivNeighborCosts;
+};
+
+
+template <class Environment, class OpenList>
+int
+NativeARAPlanner<Environment, OpenList>::replan(
+    double allocated_time_sec, std::vector<int>* solution_stateIDs_V,
+    int* solcost)
+{
+  solution_stateIDs_V->clear();
+  *solcost = INFINITECOST;
+  ivSolutionEps = -1.0;
+  ivNumExpands = 0;
+
+  if (ivStartId < 0 || ivGoalId < 0)
+  {
+    ROS_ERROR("NativeARAPlanner: start or goal state not set.");
+    return 0;
+  }
+
+  // the backward search starts at the goal
+  int search_start = ivForwardSearch ? ivStartId : ivGoalId;
+  int search_goal = ivForwardSearch ? ivGoalId : ivStartId;
+
+  ros::WallTime deadline =
+      ros::WallTime::now() + ros::WallDuration(allocated_time_sec);
+
+  ++ivSearchId;
+  ivIteration = 1;
+  ivOpen.clear();
+  ivIncons.clear();
+  ivEps = std::max(1.0, ivInitialEps);
+
+  SearchState& start = getSearchState(search_start);
+  start.g = 0;
+  ivOpen.push(search_start, key(start));
+  getSearchState(search_goal);
+
+  bool solved = false;
+  while (true)
+  {
+    // as in SBPL, the time limit does not apply before the first solution
+    // when searching until the first solution
+    bool ignore_deadline = ivSearchUntilFirstSolution && !solved;
+    SearchResult result = improvePath(search_goal, deadline, ignore_deadline);
+    if (result == SOLVED)
+    {
+      int cost = ivStates[search_goal].g;
+      bool improved = cost < *solcost &&
+          extractPath(search_start, search_goal, solution_stateIDs_V);
+      if (improved)
+      {
+        *solcost = cost;
+        solved = true;
+      }
+      ivSolutionEps = ivEps;
+      ROS_DEBUG("NativeARAPlanner: solution with eps %f, cost %d "
+                "(%d expansions)", ivEps, cost, ivNumExpands);
+      if (improved && ivSolutionCallback)
+        ivSolutionCallback(*solution_stateIDs_V, cost, ivEps);
+    }
+
+    if (result != SOLVED || ivEps <= 1.0 ||
+        (ivSearchUntilFirstSolution && solved) ||
+        ros::WallTime::now() > deadline || stopRequested())
+    {
+      break;
+    }
+
+    ivEps = std::max(1.0, ivEps - ivEpsDecrement);
+    ++ivIteration;
+    reorderOpen();
+  }
+
+  return solved ? 1 : 0;
+}
+
+
+template <class Environment, class OpenList>
+typename NativeARAPlanner<Environment, OpenList>::SearchResult
+NativeARAPlanner<Environment, OpenList>::improvePath(
+    int search_goal, const ros::WallTime& deadline, bool ignore_deadline)
+{
+  while (!ivOpen.empty())
+  {
+    // the goal's key is its g-value (h(goal) = 0)
+    if (ivStates[search_goal].g <= ivOpen.topKey())
+      return SOLVED;
+
+    if ((ivNumExpands & 0xff) == 0 &&
+        ((!ignore_deadline && ros::WallTime::now() > deadline) ||
+         stopRequested()))
+    {
+      return INTERRUPTED;
+    }
+
+    int id = ivOpen.pop();
+    int g;
+    {
+      SearchState& s = ivStates[id];
+      s.closed = ivIteration;
+      g = s.g;
+    }
+    ++ivNumExpands;
+
+    if (ivForwardSearch)
+      ivEnvironment->Environment::GetSuccs(id, &ivNeighborIds,
+                                           &ivNeighborCosts);
+    else
+      ivEnvironment->Environment::GetPreds(id, &ivNeighborIds,
+                                           &ivNeighborCosts);
+
+    for (size_t i = 0; i < ivNeighborIds.size(); ++i)
+    {
+      int neighbor_id = ivNeighborIds[i];
+      int new_g = g + ivNeighborCosts[i];
+      SearchState& n = getSearchState(neighbor_id);
+      if (new_g >= n.g)
+        continue;
+
+      n.g = new_g;
+      n.bp = id;
+      if (n.closed != ivIteration)
+      {
+        ivOpen.push(neighbor_id, key(n));
+      }
+      else if (n.incons != ivIteration)
+      {
+        n.incons = ivIteration;
+        ivIncons.push_back(neighbor_id);
+      }
+    }
+  }
+
+  if (ivStates[search_goal].g < INFINITECOST)
+    return SOLVED;
+  return EXHAUSTED;
+}
+
+
+template <class Environment, class OpenList>
+void
+NativeARAPlanner<Environment, OpenList>::reorderOpen()
+{
+  std::vector<int> ids;
+  ids.swap(ivIncons);
+  ivOpen.getIds(&ids);
+  ivOpen.clear();
+
+  std::vector<int>::const_iterator id_iter;
+  for (id_iter = ids.begin(); id_iter != ids.end(); ++id_iter)
+    ivOpen.push(*id_iter, key(ivStates[*id_iter]));
+}
+
+
+template <class Environment, class OpenList>
+bool
+NativeARAPlanner<Environment, OpenList>::extractPath(
+    int search_start, int search_goal, std::vector<int>* solution)
+const
+{
+  std::vector<int> path;
+  int id = search_goal;
+  while (id != search_start)
+  {
+    if (id < 0 || path.size() > ivStates.size())
+    {
+      ROS_ERROR("NativeARAPlanner: broken back pointers.");
+      return false;
+    }
+    path.push_back(id);
+    id = ivStates[id].bp;
+  }
+  path.push_back(search_start);
+
+  // the back pointers of the forward search lead from the goal to the start
+  if (ivForwardSearch)
+    std::reverse(path.begin(), path.end());
+  solution->swap(path);
+
+  return true;
+}
+}
+#endif  // FOOTSTEP_PLANNER_NATIVEARAPLANNER_H_
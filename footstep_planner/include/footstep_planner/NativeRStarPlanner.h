@@ -0,0 +1,782 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_NATIVERSTARPLANNER_H_
+#define FOOTSTEP_PLANNER_NATIVERSTARPLANNER_H_
+
+#include <footstep_planner/NativeARAPlanner.h>
+#include <opencv2/core/core.hpp>
+#include <ros/ros.h>
+#include <sbpl/headers.h>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief An R* search working directly on a planning environment, with the
+ * local searches running in parallel.
+ *
+ * R* searches a sparse graph of random states at a fixed distance from each
+ * other (Environment::GetRandomSuccsatDistance() /
+ * GetRandomPredsatDistance()). The costs of an edge of this graph are
+ * estimated by the heuristic until its end state is selected from the open
+ * list, then the footsteps along the edge are computed by a local weighted
+ * A* search (Environment::GetSuccsTo()) with a limited number of expansions.
+ * States whose local search exceeds the limit or whose costs exceed the
+ * bound (epsilon times the heuristic from the start) are labeled AVOID and
+ * only considered after all other states.
+ *
+ * The local searches do not depend on each other: the next states of the
+ * open list waiting for their local path are taken as a batch and searched
+ * concurrently (cv::parallel_for_), each on a worker environment of its own
+ * which follows the map and the start / goal states of the main environment
+ * (Environment::resetTo()). The i-th local search of a batch always runs on
+ * the i-th worker and the results are applied in the order of the batch, so
+ * a solution only depends on the seed of the random states and on the number
+ * of workers, not on the thread scheduling (unless the time is up).
+ *
+ * Apart from the SBPLPlanner interface the Environment has to provide
+ * GetFromToHeuristic() between arbitrary states (as used by the workers in
+ * parallel), resetTo(), importState() and mergeExpandedStates() (see
+ * FootstepPlannerEnvironment). Each iteration of the anytime search with a
+ * decreased epsilon is a new search on new random states.
+ */
+template <class Environment, class OpenList>
+class NativeRStarPlanner : public NativeARAPlannerBase
+{
+public:
+  /**
+   * @param workers The environments of the local searches (at least one),
+   * created with the same parameters as 'environment'. The number of workers
+   * is the size of the batches of local searches.
+   */
+  NativeRStarPlanner(Environment* environment,
+                     const std::vector<Environment*>& workers,
+                     bool forward_search)
+  : ivEnvironment(environment),
+    ivForwardSearch(forward_search),
+    ivSearchUntilFirstSolution(false),
+    ivIgnoreDeadline(false),
+    ivStartId(-1),
+    ivGoalId(-1),
+    ivSearchStartId(-1),
+    ivInitialEps(3.0),
+    ivEpsDecrement(0.2),
+    ivEps(3.0),
+    ivSolutionEps(-1.0),
+    ivNumExpands(0),
+    ivLocalExpandThreshold(500),
+    ivSearchId(0)
+  {
+    environment_ = environment;
+
+    typename std::vector<Environment*>::const_iterator worker_iter;
+    for (worker_iter = workers.begin(); worker_iter != workers.end();
+         ++worker_iter)
+    {
+      ivWorkers.push_back(Worker(*worker_iter));
+    }
+  }
+
+  virtual ~NativeRStarPlanner() {}
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V)
+  {
+    int solcost;
+    return replan(allocated_time_sec, solution_stateIDs_V, &solcost);
+  }
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V, int* solcost);
+
+  virtual int set_goal(int goal_stateID)
+  {
+    ivGoalId = goal_stateID;
+    return 1;
+  }
+
+  virtual int set_start(int start_stateID)
+  {
+    ivStartId = start_stateID;
+    return 1;
+  }
+
+  virtual int force_planning_from_scratch()
+  {
+    ivStates.clear();
+    return 1;
+  }
+
+  virtual int set_search_mode(bool bSearchUntilFirstSolution)
+  {
+    ivSearchUntilFirstSolution = bSearchUntilFirstSolution;
+    return 1;
+  }
+
+  /// Each replan() starts a new search, so changed costs need no handling.
+  virtual void costs_changed(StateChangeQuery const& stateChange) {}
+
+  virtual double get_solution_eps() const { return ivSolutionEps; }
+  /// @return The expansions of the R* graph and of all local searches.
+  virtual int get_n_expands() const { return ivNumExpands; }
+  virtual void set_initialsolution_eps(double initialsolution_eps)
+  {
+    ivInitialEps = initialsolution_eps;
+  }
+  virtual double get_initial_eps() { return ivInitialEps; }
+  virtual double get_final_epsilon() { return ivSolutionEps; }
+
+  /// @brief Sets the number of expansions after which a local search gives
+  /// up and labels its state AVOID.
+  void setLocalExpandThreshold(int threshold)
+  {
+    ivLocalExpandThreshold = threshold;
+  }
+
+protected:
+  enum SearchResult { SOLVED, EXHAUSTED, INTERRUPTED, LIMIT_REACHED };
+
+  /// Search data of a state of the R* graph.
+  struct SearchState
+  {
+    SearchState()
+    : g(INFINITECOST), h(0), bp(-1), path(-1), avoid(false), closed(false),
+      search_id(0)
+    {}
+
+    int g;
+    int h;
+    /// back pointer (ID of the state of the R* graph this one was reached
+    /// from)
+    int bp;
+    /// index of the local path of the edge from bp in ivLocalPaths, -1 if it
+    /// has not been computed yet (g is then estimated)
+    int path;
+    bool avoid;
+    bool closed;
+    /// search in which the data was initialized (lazy reset)
+    unsigned int search_id;
+  };
+
+  /// Search data of a state of a local search.
+  struct LocalSearchState
+  {
+    LocalSearchState()
+    : g(INFINITECOST), h(0), bp(-1), closed(false), search_id(0)
+    {}
+
+    int g;
+    int h;
+    int bp;
+    bool closed;
+    unsigned int search_id;
+  };
+
+  /// A local search for the footsteps along an edge of the R* graph.
+  struct LocalSearch
+  {
+    /// the state of the R* graph waiting for the local path to it
+    int state;
+    /// the footsteps lead from 'from' to 'to' (IDs of the main environment)
+    int from;
+    int to;
+    /// maximal number of expansions, -1 for no limit
+    int expand_limit;
+
+    SearchResult result;
+    int cost;
+    int num_expands;
+    /// the footsteps from 'from' to 'to' (IDs of the worker environment)
+    std::vector<int> path;
+  };
+
+  /// A worker environment and the search data of its local searches.
+  struct Worker
+  {
+    Worker(Environment* e) : environment(e), goal(-1), search_id(0) {}
+
+    Environment* environment;
+    /// goal of the current local search (ID of the worker environment)
+    int goal;
+    /// worker state ID => search data
+    std::vector<LocalSearchState> states;
+    unsigned int search_id;
+    OpenList open;
+    std::vector<int> neighbor_ids;
+    std::vector<int> neighbor_costs;
+  };
+
+  /// Runs the local searches of ivBatch, used with cv::parallel_for_.
+  class LocalSearches : public cv::ParallelLoopBody
+  {
+  public:
+    LocalSearches(NativeRStarPlanner& planner) : ivPlanner(planner) {}
+
+    virtual void operator()(const cv::Range& range) const
+    {
+      for (int i = range.start; i < range.end; ++i)
+        ivPlanner.computeLocalPath(&ivPlanner.ivWorkers[i],
+                                   &ivPlanner.ivBatch[i]);
+    }
+
+  private:
+    NativeRStarPlanner& ivPlanner;
+  };
+
+  /**
+   * @return The search data of state 'id' of the R* graph, (re)initialized
+   * for the current search if necessary. Note that the reference gets
+   * invalid if the table grows, i.e. when a new state is accessed.
+   */
+  SearchState& getSearchState(int id)
+  {
+    if ((size_t)id >= ivStates.size())
+      ivStates.resize(std::max(size_t(id + 1), 2 * ivStates.size()));
+
+    SearchState& s = ivStates[id];
+    if (s.search_id != ivSearchId)
+    {
+      s.g = INFINITECOST;
+      s.bp = -1;
+      s.path = -1;
+      s.avoid = false;
+      s.closed = false;
+      s.search_id = ivSearchId;
+      if (ivForwardSearch)
+        s.h = ivEnvironment->Environment::GetGoalHeuristic(id);
+      else
+        s.h = ivEnvironment->Environment::GetStartHeuristic(id);
+    }
+    return s;
+  }
+
+  /// @return The search data of state 'id' of the worker's local search.
+  LocalSearchState& getLocalSearchState(Worker* worker, int id)
+  {
+    if ((size_t)id >= worker->states.size())
+    {
+      worker->states.resize(
+          std::max(size_t(id + 1), 2 * worker->states.size()));
+    }
+
+    LocalSearchState& s = worker->states[id];
+    if (s.search_id != worker->search_id)
+    {
+      s.g = INFINITECOST;
+      s.bp = -1;
+      s.closed = false;
+      s.search_id = worker->search_id;
+      s.h = worker->environment->Environment::GetFromToHeuristic(
+          id, worker->goal);
+    }
+    return s;
+  }
+
+  int key(int g, int h) const
+  {
+    return g + int(ivEps * h);
+  }
+
+  /**
+   * @return The heuristic costs from the start of the search to state 'id'
+   * (in the direction of the footsteps).
+   */
+  int getStartHeuristic(int id)
+  {
+    if (ivForwardSearch)
+      return ivEnvironment->Environment::GetFromToHeuristic(ivSearchStartId,
+                                                            id);
+    return ivEnvironment->Environment::GetFromToHeuristic(id,
+                                                          ivSearchStartId);
+  }
+
+  /// @brief Inserts (or updates) state 'id' in the open list of its label.
+  void pushOpen(int id)
+  {
+    const SearchState& s = ivStates[id];
+    if (s.avoid)
+      ivOpenAvoid.push(id, key(s.g, s.h));
+    else
+      ivOpen.push(id, key(s.g, s.h));
+  }
+
+  /// @return The next state of the open lists (AVOID states last) or -1.
+  int popOpen()
+  {
+    if (!ivOpen.empty())
+      return ivOpen.pop();
+    if (!ivOpenAvoid.empty())
+      return ivOpenAvoid.pop();
+    return -1;
+  }
+
+  /**
+   * @brief Searches the R* graph until the goal can be expanded, the time is
+   * up (unless ivIgnoreDeadline) or a stop is requested.
+   */
+  SearchResult searchGraph(int search_start, int search_goal);
+
+  /// @brief Adds the random states around state 'id' to the R* graph.
+  void expand(int id);
+
+  /// @brief Weighted A* search for the footsteps of 'search' on 'worker'.
+  void computeLocalPath(Worker* worker, LocalSearch* search);
+
+  /// @brief Applies the result of the local search of state search.state.
+  void applyLocalSearch(const Worker& worker, LocalSearch* search);
+
+  /**
+   * @brief Concatenates the local paths along the back pointers from the
+   * goal of the search.
+   */
+  bool extractPath(int search_start, int search_goal,
+                   std::vector<int>* solution) const;
+
+  Environment* ivEnvironment;
+  bool ivForwardSearch;
+  bool ivSearchUntilFirstSolution;
+  /// whether the time limit applies to the current search
+  bool ivIgnoreDeadline;
+  ros::WallTime ivDeadline;
+
+  int ivStartId;
+  int ivGoalId;
+  /// start of the current search (the goal for a backward search)
+  int ivSearchStartId;
+
+  double ivInitialEps;
+  double ivEpsDecrement;
+  double ivEps;
+  double ivSolutionEps;
+  int ivNumExpands;
+  int ivLocalExpandThreshold;
+
+  unsigned int ivSearchId;
+
+  /// State ID => search data of the R* graph.
+  std::vector<SearchState> ivStates;
+  OpenList ivOpen;
+  /// open states labeled AVOID
+  OpenList ivOpenAvoid;
+  /// The local paths of the R* graph's edges (IDs of the main environment).
+  std::vector<std::vector<int> > ivLocalPaths;
+
+  std::vector<Worker> ivWorkers;
+  /// The local searches running in parallel, ivBatch[i] on ivWorkers[i].
+  std::vector<LocalSearch> ivBatch;
+
+  /// Buffers for the random neighbors of the expanded state.
+  std::vector<int> ivNeighborIds;
+  std::vector<int> ivNeighborCosts;
+};
+
+
+template <class Environment, class OpenList>
+int
+NativeRStarPlanner<Environment, OpenList>::replan(
+    double allocated_time_sec, std::vector<int>* solution_stateIDs_V,
+    int* solcost)
+{
+  solution_stateIDs_V->clear();
+  *solcost = INFINITECOST;
+  ivSolutionEps = -1.0;
+  ivNumExpands = 0;
+
+  if (ivStartId < 0 || ivGoalId < 0)
+  {
+    ROS_ERROR("NativeRStarPlanner: start or goal state not set.");
+    return 0;
+  }
+  if (ivWorkers.empty())
+  {
+    ROS_ERROR("NativeRStarPlanner: no worker environments.");
+    return 0;
+  }
+
+  // the backward search starts at the goal
+  int search_start = ivForwardSearch ? ivStartId : ivGoalId;
+  int search_goal = ivForwardSearch ? ivGoalId : ivStartId;
+  ivSearchStartId = search_start;
+
+  ivDeadline = ros::WallTime::now() + ros::WallDuration(allocated_time_sec);
+
+  // the workers start from the current map and start / goal states
+  typename std::vector<Worker>::iterator worker_iter;
+  for (worker_iter = ivWorkers.begin(); worker_iter != ivWorkers.end();
+       ++worker_iter)
+  {
+    worker_iter->environment->Environment::resetTo(*ivEnvironment);
+  }
+
+  ivEps = std::max(1.0, ivInitialEps);
+
+  bool solved = false;
+  while (true)
+  {
+    // as in SBPL, the time limit does not apply before the first solution
+    // when searching until the first solution
+    ivIgnoreDeadline = ivSearchUntilFirstSolution && !solved;
+    SearchResult result = searchGraph(search_start, search_goal);
+    if (result == SOLVED)
+    {
+      int cost = ivStates[search_goal].g;
+      bool improved = cost < *solcost &&
+          extractPath(search_start, search_goal, solution_stateIDs_V);
+      if (improved)
+      {
+        *solcost = cost;
+        solved = true;
+      }
+      ivSolutionEps = ivEps;
+      ROS_DEBUG("NativeRStarPlanner: solution with eps %f, cost %d "
+                "(%d expansions)", ivEps, cost, ivNumExpands);
+      if (improved && ivSolutionCallback)
+        ivSolutionCallback(*solution_stateIDs_V, cost, ivEps);
+    }
+
+    if (result != SOLVED || ivEps <= 1.0 ||
+        (ivSearchUntilFirstSolution && solved) ||
+        ros::WallTime::now() > ivDeadline || stopRequested())
+    {
+      break;
+    }
+
+    ivEps = std::max(1.0, ivEps - ivEpsDecrement);
+  }
+
+  // the states expanded by the local searches (statistics, visualization)
+  for (worker_iter = ivWorkers.begin(); worker_iter != ivWorkers.end();
+       ++worker_iter)
+  {
+    ivEnvironment->Environment::mergeExpandedStates(
+        *worker_iter->environment);
+  }
+
+  return solved ? 1 : 0;
+}
+
+
+template <class Environment, class OpenList>
+typename NativeRStarPlanner<Environment, OpenList>::SearchResult
+NativeRStarPlanner<Environment, OpenList>::searchGraph(int search_start,
+                                                       int search_goal)
+{
+  ++ivSearchId;
+  ivOpen.clear();
+  ivOpenAvoid.clear();
+  ivLocalPaths.clear();
+
+  getSearchState(search_start).g = 0;
+  pushOpen(search_start);
+  getSearchState(search_goal);
+
+  while (true)
+  {
+    if ((!ivIgnoreDeadline && ros::WallTime::now() > ivDeadline) ||
+        stopRequested())
+    {
+      return INTERRUPTED;
+    }
+
+    // the next open states waiting for their local path form a batch, a
+    // state with a computed path ends it (and is expanded if the batch is
+    // empty)
+    ivBatch.clear();
+    int expand_id = -1;
+    while (ivBatch.size() < ivWorkers.size())
+    {
+      int id = popOpen();
+      if (id < 0)
+        break;
+
+      const SearchState& s = ivStates[id];
+      if (id == search_start || s.path >= 0)
+      {
+        if (ivBatch.empty())
+          expand_id = id;
+        else
+          pushOpen(id);
+        break;
+      }
+
+      ivBatch.push_back(LocalSearch());
+      LocalSearch& search = ivBatch.back();
+      search.state = id;
+      // the footsteps always lead towards the goal of the planning task
+      search.from = ivForwardSearch ? s.bp : id;
+      search.to = ivForwardSearch ? id : s.bp;
+      // AVOID states get their local path whatever it takes
+      search.expand_limit = s.avoid ? -1 : ivLocalExpandThreshold;
+    }
+
+    if (!ivBatch.empty())
+    {
+      cv::parallel_for_(cv::Range(0, int(ivBatch.size())),
+                        LocalSearches(*this), double(ivBatch.size()));
+      for (size_t i = 0; i < ivBatch.size(); ++i)
+        applyLocalSearch(ivWorkers[i], &ivBatch[i]);
+      continue;
+    }
+
+    if (expand_id < 0)
+      return EXHAUSTED;
+    if (expand_id == search_goal)
+      return SOLVED;
+
+    expand(expand_id);
+  }
+}
+
+
+template <class Environment, class OpenList>
+void
+NativeRStarPlanner<Environment, OpenList>::expand(int id)
+{
+  int g;
+  bool avoid;
+  {
+    SearchState& s = ivStates[id];
+    s.closed = true;
+    g = s.g;
+    avoid = s.avoid;
+  }
+  ++ivNumExpands;
+
+  // (the goal states return without touching the buffers)
+  ivNeighborIds.clear();
+  ivNeighborCosts.clear();
+  if (ivForwardSearch)
+    ivEnvironment->Environment::GetRandomSuccsatDistance(id, &ivNeighborIds,
+                                                         &ivNeighborCosts);
+  else
+    ivEnvironment->Environment::GetRandomPredsatDistance(id, &ivNeighborIds,
+                                                         &ivNeighborCosts);
+
+  for (size_t i = 0; i < ivNeighborIds.size(); ++i)
+  {
+    int neighbor_id = ivNeighborIds[i];
+    int new_g = g + ivNeighborCosts[i];
+    SearchState& n = getSearchState(neighbor_id);
+    if (n.closed || new_g >= n.g)
+      continue;
+
+    n.g = new_g;
+    n.bp = id;
+    n.path = -1;
+    // states reached from an AVOID state or whose estimated costs exceed the
+    // bound are AVOID
+    bool neighbor_avoid = avoid ||
+        new_g > int(ivEps * getStartHeuristic(neighbor_id));
+    if (neighbor_avoid != n.avoid)
+    {
+      if (n.avoid)
+        ivOpenAvoid.erase(neighbor_id);
+      else
+        ivOpen.erase(neighbor_id);
+      n.avoid = neighbor_avoid;
+    }
+    pushOpen(neighbor_id);
+  }
+}
+
+
+template <class Environment, class OpenList>
+void
+NativeRStarPlanner<Environment, OpenList>::computeLocalPath(
+    Worker* worker, LocalSearch* search)
+{
+  Environment* environment = worker->environment;
+  search->result = EXHAUSTED;
+  search->cost = INFINITECOST;
+  search->num_expands = 0;
+  search->path.clear();
+
+  int from = environment->Environment::importState(*ivEnvironment,
+                                                   search->from);
+  int to = environment->Environment::importState(*ivEnvironment, search->to);
+
+  ++worker->search_id;
+  worker->goal = to;
+  worker->open.clear();
+  getLocalSearchState(worker, to);
+  {
+    LocalSearchState& start = getLocalSearchState(worker, from);
+    start.g = 0;
+    worker->open.push(from, key(start.g, start.h));
+  }
+
+  while (!worker->open.empty())
+  {
+    // the goal's key is its g-value (h(goal) = 0)
+    if (worker->states[to].g <= worker->open.topKey())
+      break;
+
+    if (search->expand_limit >= 0 &&
+        search->num_expands >= search->expand_limit)
+    {
+      search->result = LIMIT_REACHED;
+      return;
+    }
+    if ((search->num_expands & 0xff) == 0 && !ivIgnoreDeadline &&
+        ros::WallTime::now() > ivDeadline)
+    {
+      search->result = INTERRUPTED;
+      return;
+    }
+
+    int id = worker->open.pop();
+    int g;
+    {
+      LocalSearchState& s = worker->states[id];
+      s.closed = true;
+      g = s.g;
+    }
+    ++search->num_expands;
+
+    environment->Environment::GetSuccsTo(id, to, &worker->neighbor_ids,
+                                         &worker->neighbor_costs);
+    for (size_t i = 0; i < worker->neighbor_ids.size(); ++i)
+    {
+      int neighbor_id = worker->neighbor_ids[i];
+      int new_g = g + worker->neighbor_costs[i];
+      LocalSearchState& n = getLocalSearchState(worker, neighbor_id);
+      if (n.closed || new_g >= n.g)
+        continue;
+
+      n.g = new_g;
+      n.bp = id;
+      worker->open.push(neighbor_id, key(n.g, n.h));
+    }
+  }
+
+  if (worker->states[to].g >= INFINITECOST)
+    return;
+
+  for (int id = to; id != from; id = worker->states[id].bp)
+  {
+    if (id < 0 || search->path.size() > worker->states.size())
+    {
+      ROS_ERROR("NativeRStarPlanner: broken back pointers of a local "
+                "search.");
+      search->path.clear();
+      return;
+    }
+    search->path.push_back(id);
+  }
+  search->path.push_back(from);
+  std::reverse(search->path.begin(), search->path.end());
+
+  search->result = SOLVED;
+  search->cost = worker->states[to].g;
+}
+
+
+template <class Environment, class OpenList>
+void
+NativeRStarPlanner<Environment, OpenList>::applyLocalSearch(
+    const Worker& worker, LocalSearch* search)
+{
+  ivNumExpands += search->num_expands;
+
+  SearchState& s = ivStates[search->state];
+  if (search->result == SOLVED)
+  {
+    ivLocalPaths.push_back(std::vector<int>(search->path.size()));
+    std::vector<int>& path = ivLocalPaths.back();
+    for (size_t i = 0; i < search->path.size(); ++i)
+    {
+      path[i] = ivEnvironment->Environment::importState(*worker.environment,
+                                                        search->path[i]);
+    }
+    assert(path.front() == search->from && path.back() == search->to);
+
+    s.path = ivLocalPaths.size() - 1;
+    s.g = ivStates[s.bp].g + search->cost;
+    if (s.g > int(ivEps * getStartHeuristic(search->state)))
+      s.avoid = true;
+    pushOpen(search->state);
+  }
+  else if (search->result == LIMIT_REACHED)
+  {
+    s.avoid = true;
+    pushOpen(search->state);
+  }
+  else if (search->result == INTERRUPTED)
+  {
+    pushOpen(search->state);
+  }
+  else
+  {
+    // no footsteps along the edge, the state stays out of the open list
+    // until it is reached from another state
+    s.g = INFINITECOST;
+    s.bp = -1;
+  }
+}
+
+
+template <class Environment, class OpenList>
+bool
+NativeRStarPlanner<Environment, OpenList>::extractPath(
+    int search_start, int search_goal, std::vector<int>* solution)
+const
+{
+  // the states of the R* graph from the goal of the search (excluding its
+  // start), each with the local path of the edge from its back pointer
+  std::vector<int> graph_path;
+  int id = search_goal;
+  while (id != search_start)
+  {
+    if (id < 0 || ivStates[id].path < 0 ||
+        graph_path.size() > ivStates.size())
+    {
+      ROS_ERROR("NativeRStarPlanner: broken back pointers.");
+      return false;
+    }
+    graph_path.push_back(id);
+    id = ivStates[id].bp;
+  }
+
+  // the local paths lead towards the goal of the planning task, i.e. for the
+  // forward search from the back pointer to the state
+  if (ivForwardSearch)
+    std::reverse(graph_path.begin(), graph_path.end());
+
+  std::vector<int> path;
+  std::vector<int>::const_iterator graph_iter;
+  for (graph_iter = graph_path.begin(); graph_iter != graph_path.end();
+       ++graph_iter)
+  {
+    const std::vector<int>& local_path =
+        ivLocalPaths[ivStates[*graph_iter].path];
+    // consecutive local paths share their end states
+    path.insert(path.end(), local_path.begin() + (path.empty() ? 0 : 1),
+                local_path.end());
+  }
+  solution->swap(path);
+
+  return true;
+}
+}
+#endif  // FOOTSTEP_PLANNER_NATIVERSTARPLANNER_H_
@@ -0,0 +1,412 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_OPENLIST_H_
+#define FOOTSTEP_PLANNER_OPENLIST_H_
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/*
+ * Open lists of the native planners. All of them provide the operations
+ * empty(), size(), contains(id), topKey(), push(id, key) (insert or update),
+ * pop(), erase(id), getIds(ids) and clear() on integer state IDs and keys.
+ */
+
+/**
+ * @brief Open list of the NativeARAPlanner: a d-ary min-heap of state IDs
+ * with integer keys.
+ *
+ * The heap position of each contained state is kept in a flat table indexed
+ * by the state ID, so that the key of a contained state can be updated in
+ * place (no duplicate entries). A small arity > 2 results in a shallower
+ * heap whose children lie next to each other in memory.
+ */
+template <int Arity>
+class DAryHeap
+{
+public:
+  DAryHeap() {}
+
+  bool empty() const { return ivHeap.empty(); }
+  size_t size() const { return ivHeap.size(); }
+
+  /// @return True iff the state 'id' is in the open list.
+  bool contains(int id) const
+  {
+    return (size_t)id < ivPosition.size() && ivPosition[id] >= 0;
+  }
+
+  /// @return The smallest key in the open list (must not be empty).
+  int topKey() const
+  {
+    assert(!empty());
+    return ivHeap[0].key;
+  }
+
+  /**
+   * @brief Inserts the state 'id' with the key 'key' or updates its key if
+   * it is already contained.
+   */
+  void push(int id, int key)
+  {
+    if ((size_t)id >= ivPosition.size())
+      ivPosition.resize(id + 1, -1);
+
+    int pos = ivPosition[id];
+    if (pos < 0)
+    {
+      pos = ivHeap.size();
+      ivHeap.push_back(Element(key, id));
+      ivPosition[id] = pos;
+      siftUp(pos);
+    }
+    else if (key < ivHeap[pos].key)
+    {
+      ivHeap[pos].key = key;
+      siftUp(pos);
+    }
+    else
+    {
+      ivHeap[pos].key = key;
+      siftDown(pos);
+    }
+  }
+
+  /// @brief Removes and returns the state with the smallest key.
+  int pop()
+  {
+    assert(!empty());
+    int id = ivHeap[0].id;
+    ivPosition[id] = -1;
+    if (ivHeap.size() > 1)
+    {
+      ivHeap[0] = ivHeap.back();
+      ivPosition[ivHeap[0].id] = 0;
+      ivHeap.pop_back();
+      siftDown(0);
+    }
+    else
+    {
+      ivHeap.pop_back();
+    }
+    return id;
+  }
+
+  /// @brief Removes the state 'id' (if it is contained).
+  void erase(int id)
+  {
+    if (!contains(id))
+      return;
+
+    int pos = ivPosition[id];
+    ivPosition[id] = -1;
+    Element last = ivHeap.back();
+    ivHeap.pop_back();
+    if (pos == (int)ivHeap.size())
+      return;
+
+    ivHeap[pos] = last;
+    ivPosition[last.id] = pos;
+    siftUp(pos);
+    siftDown(ivPosition[last.id]);
+  }
+
+  /// @brief Appends the IDs of all contained states to 'ids'.
+  void getIds(std::vector<int>* ids) const
+  {
+    typename std::vector<Element>::const_iterator iter;
+    for (iter = ivHeap.begin(); iter != ivHeap.end(); ++iter)
+      ids->push_back(iter->id);
+  }
+
+  void clear()
+  {
+    typename std::vector<Element>::const_iterator iter;
+    for (iter = ivHeap.begin(); iter != ivHeap.end(); ++iter)
+      ivPosition[iter->id] = -1;
+    ivHeap.clear();
+  }
+
+private:
+  struct Element
+  {
+    Element(int k, int i) : key(k), id(i) {}
+    int key;
+    int id;
+  };
+
+  void siftUp(int pos)
+  {
+    Element e = ivHeap[pos];
+    while (pos > 0)
+    {
+      int parent = (pos - 1) / Arity;
+      if (ivHeap[parent].key <= e.key)
+        break;
+      ivHeap[pos] = ivHeap[parent];
+      ivPosition[ivHeap[pos].id] = pos;
+      pos = parent;
+    }
+    ivHeap[pos] = e;
+    ivPosition[e.id] = pos;
+  }
+
+  void siftDown(int pos)
+  {
+    Element e = ivHeap[pos];
+    int size = ivHeap.size();
+    while (true)
+    {
+      int first_child = pos * Arity + 1;
+      if (first_child >= size)
+        break;
+      int last_child = first_child + Arity;
+      if (last_child > size)
+        last_child = size;
+
+      int min_child = first_child;
+      for (int c = first_child + 1; c < last_child; ++c)
+      {
+        if (ivHeap[c].key < ivHeap[min_child].key)
+          min_child = c;
+      }
+      if (e.key <= ivHeap[min_child].key)
+        break;
+      ivHeap[pos] = ivHeap[min_child];
+      ivPosition[ivHeap[pos].id] = pos;
+      pos = min_child;
+    }
+    ivHeap[pos] = e;
+    ivPosition[e.id] = pos;
+  }
+
+  std::vector<Element> ivHeap;
+  /// State ID => position in ivHeap (-1 if not contained).
+  std::vector<int> ivPosition;
+};
+
+
+/**
+ * @brief Open list of the NativeARAPlanner: a bucket queue with one bucket
+ * per integer key.
+ *
+ * Footstep costs are integers (in mm) and the keys of the open states lie
+ * within a narrow band around the current f-value, so push() is O(1) and
+ * pop() only has to scan the few buckets between two consecutive minimal
+ * keys. Key updates are lazy: the state is appended to the bucket of its new
+ * key and its older entries become stale (detected by a per-state stamp)
+ * and are skipped on pop().
+ *
+ * Buckets are allocated as needed on both ends of the key range (with an
+ * inflated heuristic, a pushed key can be smaller than the current minimum)
+ * and are kept for reuse over clear().
+ */
+class BucketQueue
+{
+public:
+  BucketQueue() : ivBase(0), ivMinBucket(0), ivMaxBucket(-1), ivSize(0) {}
+
+  bool empty() const { return ivSize == 0; }
+  size_t size() const { return ivSize; }
+
+  /// @return True iff the state 'id' is in the open list.
+  bool contains(int id) const
+  {
+    return (size_t)id < ivStates.size() && ivStates[id].key != cvNotContained;
+  }
+
+  /// @return The smallest key in the open list (must not be empty).
+  int topKey() const
+  {
+    assert(!empty());
+    settle();
+    return ivBase + ivMinBucket;
+  }
+
+  /**
+   * @brief Inserts the state 'id' with the key 'key' or updates its key if
+   * it is already contained.
+   */
+  void push(int id, int key)
+  {
+    if ((size_t)id >= ivStates.size())
+      ivStates.resize(id + 1);
+
+    StateEntry& state = ivStates[id];
+    if (state.key == key)
+      return;
+
+    if (ivSize == 0)
+    {
+      // empty queue: drop the stale entries and rebase the buckets such
+      // that the new key lies in their middle
+      for (int b = ivMinBucket; b <= ivMaxBucket; ++b)
+        ivBuckets[b].clear();
+      int offset = ivBuckets.size() / 2;
+      ivBase = key - offset;
+      ivMinBucket = ivMaxBucket = offset;
+    }
+    if (state.key == cvNotContained)
+      ++ivSize;
+    state.key = key;
+    ++state.stamp;
+    int bucket = key - ivBase;
+    if (bucket < 0)
+    {
+      growFront(-bucket);
+      bucket = key - ivBase;
+    }
+    if (bucket >= (int)ivBuckets.size())
+      ivBuckets.resize(std::max(size_t(bucket + 1), 2 * ivBuckets.size()));
+
+    ivBuckets[bucket].push_back(BucketEntry(id, state.stamp));
+    if (bucket < ivMinBucket)
+      ivMinBucket = bucket;
+    if (bucket > ivMaxBucket)
+      ivMaxBucket = bucket;
+  }
+
+  /// @brief Removes and returns a state with the smallest key.
+  int pop()
+  {
+    assert(!empty());
+    settle();
+    int id = ivBuckets[ivMinBucket].back().id;
+    ivBuckets[ivMinBucket].pop_back();
+    ivStates[id].key = cvNotContained;
+    --ivSize;
+    return id;
+  }
+
+  /// @brief Removes the state 'id' (if it is contained), its bucket entry
+  /// becomes stale.
+  void erase(int id)
+  {
+    if (!contains(id))
+      return;
+
+    ivStates[id].key = cvNotContained;
+    --ivSize;
+  }
+
+  /// @brief Appends the IDs of all contained states to 'ids'.
+  void getIds(std::vector<int>* ids) const
+  {
+    for (int b = ivMinBucket; b <= ivMaxBucket; ++b)
+    {
+      std::vector<BucketEntry>::const_iterator iter;
+      for (iter = ivBuckets[b].begin(); iter != ivBuckets[b].end(); ++iter)
+      {
+        if (valid(*iter))
+          ids->push_back(iter->id);
+      }
+    }
+  }
+
+  void clear()
+  {
+    for (int b = ivMinBucket; b <= ivMaxBucket; ++b)
+    {
+      std::vector<BucketEntry>::const_iterator iter;
+      for (iter = ivBuckets[b].begin(); iter != ivBuckets[b].end(); ++iter)
+        ivStates[iter->id].key = cvNotContained;
+      ivBuckets[b].clear();
+    }
+    ivMinBucket = 0;
+    ivMaxBucket = -1;
+    ivSize = 0;
+  }
+
+private:
+  static const int cvNotContained = INT_MIN;
+
+  struct BucketEntry
+  {
+    BucketEntry(int i, unsigned int s) : id(i), stamp(s) {}
+    int id;
+    unsigned int stamp;
+  };
+
+  struct StateEntry
+  {
+    StateEntry() : key(cvNotContained), stamp(0) {}
+    int key;
+    /// Incremented on every push, only the latest bucket entry is valid.
+    unsigned int stamp;
+  };
+
+  bool valid(const BucketEntry& entry) const
+  {
+    const StateEntry& state = ivStates[entry.id];
+    return state.key != cvNotContained && state.stamp == entry.stamp;
+  }
+
+  /**
+   * @brief Drops the stale entries at the front of the queue such that the
+   * last entry of ivBuckets[ivMinBucket] is a valid one.
+   */
+  void settle() const
+  {
+    while (true)
+    {
+      std::vector<BucketEntry>& bucket = ivBuckets[ivMinBucket];
+      while (!bucket.empty() && !valid(bucket.back()))
+        bucket.pop_back();
+      if (!bucket.empty())
+        return;
+      ++ivMinBucket;
+    }
+  }
+
+  /// @brief Prepends at least 'num' buckets (moving the existing ones).
+  void growFront(int num)
+  {
+    num = std::max(num, (int)ivBuckets.size());
+    std::vector<std::vector<BucketEntry> > buckets(ivBuckets.size() + num);
+    for (int b = ivMinBucket; b <= ivMaxBucket; ++b)
+      buckets[b + num].swap(ivBuckets[b]);
+    ivBuckets.swap(buckets);
+    ivBase -= num;
+    ivMinBucket += num;
+    ivMaxBucket += num;
+  }
+
+  /// Key of ivBuckets[0].
+  int ivBase;
+  /// Range of buckets which may contain entries (mutable for the lazy
+  /// removal of stale entries in topKey()).
+  mutable int ivMinBucket;
+  int ivMaxBucket;
+  size_t ivSize;
+
+  mutable std::vector<std::vector<BucketEntry> > ivBuckets;
+  /// State ID => current key and stamp.
+  std::vector<StateEntry> ivStates;
+};
+}
+#endif  // FOOTSTEP_PLANNER_OPENLIST_H_
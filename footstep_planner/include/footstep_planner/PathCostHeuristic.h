@@ -23,6 +23,7 @@
 
 #include <footstep_planner/Heuristic.h>
 #include <gridmap_2d/GridMap2D.h>
+#include <gridmap_2d/GridMap2DView.h>
 #include <sbpl/headers.h>
 
 
@@ -65,7 +66,19 @@ public:
    */
   bool calculateDistances(const PlanningState& from, const PlanningState& to);
 
-  void updateMap(gridmap_2d::GridMap2DPtr map);
+  /**
+   * @brief Calculates the 2D path from the world position (from_x, from_y)
+   * to (to_x, to_y) by calculating the 2D path costs of all grid cells to
+   * (to_x, to_y) (as calculateDistances()) and following their descent.
+   *
+   * @param path The positions of the grid cells along the path.
+   * @return False if (to_x, to_y) cannot be reached.
+   */
+  bool calculatePath2D(double from_x, double from_y,
+                       double to_x, double to_y,
+                       std::vector<std::pair<double, double> >* path);
+
+  void updateMap(gridmap_2d::GridMap2DConstPtr map);
 
 private:
   static const int cvObstacleThreshold = 200;
@@ -80,10 +93,16 @@ private:
   int ivGoalX;
   int ivGoalY;
 
-  gridmap_2d::GridMap2DPtr ivMapPtr;
+  gridmap_2d::GridMap2DConstPtr ivMapPtr;
+  gridmap_2d::GridMap2DView ivMapView;
+  /// revision of ivMapPtr the grid was computed for
+  unsigned long ivMapRevision;
   boost::shared_ptr<SBPL2DGridSearch> ivGridSearchPtr;
 
   void resetGrid();
+  /// sets the grid cells within 'region' (x, y: map cells) from the
+  /// inflated binary map
+  void updateGrid(const cv::Mat& inflated, const cv::Rect& region);
 };
 }
 #endif  // FOOTSTEP_PLANNER_PATHCOSTHEURISTIC_H_
@@ -26,6 +26,7 @@
 
 
 #include <gridmap_2d/GridMap2D.h>
+#include <gridmap_2d/GridMap2DView.h>
 #include <angles/angles.h>
 #include <tf/tf.h>
 
@@ -197,6 +198,12 @@ inline int round(double r)
  *
  * @return True if the footstep collides with an obstacle.
  */
+bool collision_check(double x, double y, double theta,
+                     double height, double width, int accuracy,
+                     const gridmap_2d::GridMap2DView& distance_map);
+
+
+/// @brief Same as above for a GridMap2D.
 bool collision_check(double x, double y, double theta,
                      double height, double width, int accuracy,
                      const gridmap_2d::GridMap2D& distance_map);
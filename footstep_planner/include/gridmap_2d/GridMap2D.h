@@ -35,6 +35,13 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <nav_msgs/OccupancyGrid.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
 
 
 
@@ -49,8 +56,18 @@ namespace gridmap_2d{
 class GridMap2D {
 public:
   GridMap2D();
-  ///@brief Create from nav_msgs::OccupancyGrid
-  GridMap2D(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle = false);
+  ///@brief Create from nav_msgs::OccupancyGrid (see setMap)
+  GridMap2D(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle = false,
+            int occupied_threshold = DEFAULT_OCCUPIED_THRESHOLD);
+  /**
+   * @brief Create from nav_msgs::OccupancyGrid as the successor of 'previous'
+   * (e.g. the map of the previous message): the differences to it are
+   * recorded in the journal continued from 'previous', so that
+   * getChangesSince() works across messages. The distance map depth is
+   * taken from 'previous'.
+   */
+  GridMap2D(const nav_msgs::OccupancyGridConstPtr& grid_map, const GridMap2D& previous,
+            bool unknown_as_obstacle = false, int occupied_threshold = DEFAULT_OCCUPIED_THRESHOLD);
   ///@brief Copy constructor, performs a deep copy of underlying data structures
   GridMap2D(const GridMap2D& other);
   virtual ~GridMap2D();
@@ -67,6 +84,15 @@ public:
    */
   void inflateMap(double inflationRaduis);
 
+  /**
+   * @brief Binary map inflated by 'radius' (in m): free (255) where the
+   * distance map is above radius, thresholded from the existing distance
+   * map. The result is memoized per radius until the map changes and its
+   * data is shared between all callers, so it must not be modified
+   * (clone it for changes). Thread-safe.
+   */
+  cv::Mat inflatedBinaryMap(double radius) const;
+
   /// Distance (in m) between two map coordinates (indices)
   inline double worldDist(unsigned x1, unsigned y1, unsigned x2, unsigned y2){
     return worldDist(cv::Point(x1, y1), cv::Point(x2, y2));
@@ -108,8 +134,23 @@ public:
   /// @return true if map is occupied at cell <mx, my>
   bool isOccupiedAtCell(unsigned int mx, unsigned int my) const;
 
-  ///@brief Initialize map from a ROS OccupancyGrid message
-  void setMap(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle = false);
+  /**
+   * @brief Initialize map from a ROS OccupancyGrid message. Cells with an
+   * occupancy value above occupied_threshold (and unknown ones if
+   * unknown_as_obstacle) are occupied.
+   */
+  void setMap(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle = false,
+              int occupied_threshold = DEFAULT_OCCUPIED_THRESHOLD);
+
+  /**
+   * @brief Applies a patch of the OccupancyGrid (e.g. from a map server's
+   * "map_updates" topic) in place. The patch is thresholded as in the last
+   * setMap(), and the distance map is repaired incrementally around the
+   * cells that changed (see updateDistanceMap(changed_cells)).
+   *
+   * @return false if the patch does not fit into the map (nothing changed)
+   */
+  bool applyUpdate(const map_msgs::OccupancyGridUpdateConstPtr& update);
 
   ///@brief Converts back into a ROS nav_msgs::OccupancyGrid msg
   nav_msgs::OccupancyGrid toOccupancyGridMsg() const;
@@ -120,12 +161,63 @@ public:
   ///@brief Recalculate the internal distance map. Required after manual changes to the grid map data.
   void updateDistanceMap();
 
+  /**
+   * @brief Incrementally updates the distance map after the cells
+   * 'changed_cells' (map cells <mx, my>) were modified in the binary map,
+   * e.g. with binaryMapAtCell(). Only the cells whose closest obstacle
+   * changes are updated (dynamic brushfire), so the cost scales with the
+   * size of the change instead of the map.
+   *
+   * The first call propagates all obstacles once to initialize the
+   * required data; any full recomputation (setMap, inflateMap,
+   * updateDistanceMap()) discards it again.
+   */
+  void updateDistanceMap(const std::vector<cv::Point>& changed_cells);
+
+  ///@brief Incrementally updates the distance map after changes within the
+  /// cells 'changed_region' (x: mx, y: my), see above.
+  void updateDistanceMap(const cv::Rect& changed_region);
+
+  /**
+   * @brief Sets how the distance map is stored: as float in m (depth
+   * CV_32F, default) or quantized as CV_8U / CV_16U in steps of
+   * max_distance / 255 (65535), saturated at max_distance. Quantized
+   * distances are rounded down, the accessors still return meters.
+   * Recomputes the distance map.
+   */
+  void setDistanceMapDepth(int depth, double max_distance = 0.0);
+
+  /**
+   * @return the revision of the map content. Every change of the binary
+   * map gets a new, process-wide unique revision (copies keep it).
+   */
+  inline unsigned long getRevision() const {return m_revision;}
+
+  /**
+   * @brief Regions of map cells (x: mx, y: my) of the binary map changed
+   * since 'revision' of this map (or of the map it was copied from or
+   * created as successor of). The
+   * distance map can also change around them, up to the distance to the
+   * changed obstacles.
+   *
+   * @return false if the changes are unknown (revision not in the journal,
+   * map geometry changed or updateDistanceMap() after manual changes): a
+   * full update is needed then.
+   */
+  bool getChangesSince(unsigned long revision, std::vector<cv::Rect>& changed_regions) const;
+
   inline const nav_msgs::MapMetaData& getInfo() const {return m_mapInfo;}
   inline float getResolution() const {return m_mapInfo.resolution; }
   /// returns the tf frame ID of the map (usually "/map")
   inline const std::string getFrameID() const {return m_frameId;}
-  /// @return the cv::Mat distance image.
+  /// @return the cv::Mat distance image (in m), empty if the distance map is quantized.
   const cv::Mat& distanceMap() const {return m_distMap;}
+  /// @return the quantized distance image, empty if not quantized (see setDistanceMapDepth).
+  const cv::Mat& quantizedDistanceMap() const {return m_quantizedDistMap;}
+  /// @return the depth of the distance map (CV_32F, CV_8U or CV_16U)
+  inline int getDistanceMapDepth() const {return m_distMapDepth;}
+  /// @return the distance (in m) of one step of the quantized distance map
+  inline float getDistanceQuantum() const {return m_distQuantum;}
   /// @return the cv::Mat binary image.
   const cv::Mat& binaryMap() const {return m_binaryMap;}
   /// @return the size of the cv::Mat binary image. Note that x/y are swapped wrt. height/width
@@ -133,12 +225,85 @@ public:
 
   const static uchar FREE = 255;  ///< char value for "free": 255
   const static uchar OCCUPIED = 0; ///< char value for "free": 0
+  /// cells of an OccupancyGrid above this value are occupied by default
+  const static int DEFAULT_OCCUPIED_THRESHOLD = 70;
 
 protected:
   cv::Mat m_binaryMap;	///< binary occupancy map. 255: free, 0 occupied.
   cv::Mat m_distMap;		///< distance map (in meter)
+  cv::Mat m_quantizedDistMap; ///< distance map (in m_distQuantum), replaces m_distMap if used
+  int m_distMapDepth;   ///< depth of the distance map (CV_32F: m_distMap)
+  float m_distQuantum;  ///< distance (in m) of one step of m_quantizedDistMap
   nav_msgs::MapMetaData m_mapInfo;
   std::string m_frameId;	///< "map" frame where ROS OccupancyGrid originated from
+  bool m_unknownAsObstacle; ///< conversion of OccupancyGrid values in the last setMap()
+  int m_occupiedThreshold;  ///< conversion of OccupancyGrid values in the last setMap()
+
+  /// @return lookup table (1 x 256) from occupancy values (as uchar) to
+  /// binary map values, for the conversion of the last setMap()
+  cv::Mat occupancyLut() const;
+
+  /// thresholds and transposes strips of rows of an OccupancyGrid (as
+  /// CV_8UC1) into the binary map, used with cv::parallel_for_
+  class OccupancyConversion : public cv::ParallelLoopBody {
+  public:
+    OccupancyConversion(const cv::Mat& occupancy, const cv::Mat& lut, cv::Mat& binary_map);
+    virtual void operator()(const cv::Range& rows) const;
+  private:
+    const cv::Mat& m_occupancy;
+    const cv::Mat& m_lut;
+    cv::Mat& m_binaryMap;
+  };
+
+  /// recomputes the distance map from the binary map
+  void computeDistanceMap();
+
+  /// @return the next process-wide unique revision
+  static unsigned long nextRevision();
+  /// records the changes of the binary map against previous_map
+  void recordChanges(const cv::Mat& previous_map, const nav_msgs::MapMetaData& previous_info);
+  /// records a change of 'changed_regions' as new revision
+  void recordChange(const std::vector<cv::Rect>& changed_regions);
+  /// records a new revision without known changes
+  void recordUnknownChange();
+
+  /// side length of the blocks of cells in which changes are recorded
+  const static int CHANGE_BLOCK_SIZE = 32;
+  /// number of changes kept in the journal
+  const static size_t MAX_JOURNAL_SIZE = 32;
+
+  struct MapChange{
+    unsigned long revision;           ///< revision created by the change
+    std::vector<cv::Rect> regions;    ///< changed cells (x: mx, y: my)
+  };
+
+  static boost::mutex s_revisionMutex;
+  static unsigned long s_lastRevision;
+  unsigned long m_revision;
+  unsigned long m_journalBase;        ///< revision before m_changes.front()
+  std::deque<MapChange> m_changes;    ///< journal of the latest changes
+
+  /// drops the memoized inflated binary maps
+  void clearInflatedBinaryMaps();
+
+  /// inflated binary maps by radius (see inflatedBinaryMap)
+  mutable std::map<double, cv::Mat> m_inflatedBinaryMaps;
+  mutable boost::mutex m_inflatedBinaryMapsMutex;
+
+  /// initializes the data of the incremental distance map update
+  void initIncrementalDistanceMap();
+  /// propagates the queued obstacle changes through the distance map
+  void propagateDistanceChanges();
+  /// sets the squared distance (in cells) of a cell and its distance map entry
+  void setSquaredDistance(int idx, int sq_dist);
+
+  // Data of the incremental distance map update for each cell (index
+  // mx * height + my), empty until the first incremental update:
+  std::vector<int> m_closestObstacle; ///< closest obstacle cell, -1 if none
+  std::vector<int> m_sqDist;          ///< squared distance (in cells) to it
+  std::vector<bool> m_raise;          ///< cell lost its closest obstacle
+  /// open list (squared distance, cell) of the brushfire
+  std::vector<std::pair<int, int> > m_open;
 
 };
 
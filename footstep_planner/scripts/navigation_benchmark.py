@@ -0,0 +1,170 @@
+#!/usr/bin/env python
+
+#
+# Closed-loop benchmark of the footstep navigation: runs the scripted
+# navigation tasks of the parameter 'scenarios' (see
+# config/navigation_benchmark.yaml) against a running footstep_navigation
+# node and the simulated footstep execution (footstep_execution_sim) and
+# reports for each task
+#  - the time from sending the goal to the start of the first footstep,
+#  - the number of footstep plans (published paths of the navigation),
+#  - the idle time between footsteps (robot standing after a step until the
+#    next one starts, e.g. while replanning) and the longest such break.
+#
+# Start everything with launch/footstep_navigation_sim_benchmark.launch
+#
+# This is program is part of the ROS footstep planner:
+# http://www.ros.org/wiki/footstep_planner
+# License: GPL 3
+#
+
+import roslib
+roslib.load_manifest('footstep_planner')
+import rospy
+
+from geometry_msgs.msg import PoseStamped, PoseWithCovarianceStamped
+from nav_msgs.msg import Path
+from tf.transformations import quaternion_from_euler
+
+import math
+import threading
+
+
+class NavigationBenchmark:
+    def __init__(self):
+        self.timeout = rospy.get_param('~timeout', 120.0)
+        self.goal_tolerance = rospy.get_param('~goal_tolerance', 0.1)
+        self.stop_time = rospy.get_param('~stop_time', 5.0)
+        self.step_duration = rospy.get_param(
+            'footstep_execution_sim/step_duration', 0.5)
+        self.frame_id = rospy.get_param('~frame_id', 'map')
+
+        self.lock = threading.Lock()
+        self.step_starts = []
+        self.step_poses = []
+        self.num_plans = 0
+
+        self.start_pub = rospy.Publisher('initialpose',
+                                         PoseWithCovarianceStamped,
+                                         queue_size=1, latch=True)
+        self.goal_pub = rospy.Publisher('goal', PoseStamped, queue_size=1)
+        rospy.Subscriber('footstep_execution_sim/executed_footstep',
+                         PoseStamped, self.footstep_callback)
+        rospy.Subscriber('footstep_navigation/path', Path, self.path_callback)
+
+    def footstep_callback(self, msg):
+        with self.lock:
+            self.step_starts.append(msg.header.stamp.to_sec())
+            self.step_poses.append((msg.pose.position.x, msg.pose.position.y))
+
+    def path_callback(self, msg):
+        with self.lock:
+            self.num_plans += 1
+
+    def pose(self, msg_type, x, y, theta):
+        msg = msg_type()
+        msg.header.frame_id = self.frame_id
+        msg.header.stamp = rospy.Time.now()
+        pose = msg.pose.pose if msg_type is PoseWithCovarianceStamped \
+            else msg.pose
+        pose.position.x = x
+        pose.position.y = y
+        q = quaternion_from_euler(0.0, 0.0, theta)
+        pose.orientation.x, pose.orientation.y, pose.orientation.z, \
+            pose.orientation.w = q
+        return msg
+
+    def run_scenario(self, scenario):
+        start = scenario['start']
+        goal = scenario['goal']
+
+        # place the robot and wait for its feet to settle
+        self.start_pub.publish(self.pose(PoseWithCovarianceStamped, *start))
+        rospy.sleep(2.0)
+        with self.lock:
+            self.step_starts = []
+            self.step_poses = []
+            self.num_plans = 0
+
+        goal_time = rospy.Time.now().to_sec()
+        self.goal_pub.publish(self.pose(PoseStamped, *goal))
+
+        reached = False
+        while not rospy.is_shutdown():
+            rospy.sleep(0.1)
+            now = rospy.Time.now().to_sec()
+            with self.lock:
+                last_step = self.step_starts[-1] + self.step_duration \
+                    if self.step_starts else goal_time
+                poses = self.step_poses[-2:]
+            if now - goal_time > self.timeout:
+                break
+            if len(poses) < 2 or now - last_step < self.stop_time:
+                continue
+            # the robot stopped walking: check the center of its feet
+            x = (poses[0][0] + poses[1][0]) / 2.0
+            y = (poses[0][1] + poses[1][1]) / 2.0
+            reached = math.hypot(x - goal[0], y - goal[1]) < \
+                self.goal_tolerance
+            break
+
+        with self.lock:
+            starts = list(self.step_starts)
+            num_plans = self.num_plans
+
+        result = {'name': scenario.get('name', ''), 'reached': reached,
+                  'steps': len(starts), 'plans': num_plans,
+                  'time_to_first_step': float('nan'),
+                  'idle_time': 0.0, 'max_break': 0.0, 'total_time': 0.0}
+        if starts:
+            result['time_to_first_step'] = starts[0] - goal_time
+            breaks = [max(0.0, b - a - self.step_duration)
+                      for a, b in zip(starts[:-1], starts[1:])]
+            if breaks:
+                result['idle_time'] = sum(breaks)
+                result['max_break'] = max(breaks)
+            result['total_time'] = starts[-1] + self.step_duration - goal_time
+        return result
+
+    def run(self, scenarios):
+        results = []
+        for scenario in scenarios:
+            rospy.loginfo("Scenario '%s': from %s to %s",
+                          scenario.get('name', ''), scenario['start'],
+                          scenario['goal'])
+            result = self.run_scenario(scenario)
+            results.append(result)
+            rospy.loginfo("  %s: first step after %.3f s, %d steps, "
+                          "%d plans, idle %.3f s (max. break %.3f s), "
+                          "total %.3f s",
+                          "reached" if result['reached'] else "FAILED",
+                          result['time_to_first_step'], result['steps'],
+                          result['plans'], result['idle_time'],
+                          result['max_break'], result['total_time'])
+            if rospy.is_shutdown():
+                break
+
+        rospy.loginfo("%-20s %7s %8s %6s %6s %8s %9s %8s", "scenario",
+                      "reached", "1st step", "steps", "plans", "idle",
+                      "max break", "total")
+        for r in results:
+            rospy.loginfo("%-20s %7s %8.3f %6d %6d %8.3f %9.3f %8.3f",
+                          r['name'], r['reached'], r['time_to_first_step'],
+                          r['steps'], r['plans'], r['idle_time'],
+                          r['max_break'], r['total_time'])
+
+
+if __name__ == '__main__':
+    rospy.init_node('navigation_benchmark')
+
+    scenarios = rospy.get_param('~scenarios', [])
+    if not scenarios:
+        rospy.logerr("No benchmark scenarios given (parameter ~scenarios)")
+        exit(1)
+
+    benchmark = NavigationBenchmark()
+    # wait for the other nodes to come up
+    rospy.sleep(3.0)
+    benchmark.run(scenarios)
+
+    exit(0)
@@ -0,0 +1,200 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/ExpandedStates2D.h>
+
+#include <string.h>
+
+
+namespace footstep_planner
+{
+ExpandedStates2D::ExpandedStates2D()
+: ivMinX(0),
+  ivMinY(0),
+  ivSizeX(0),
+  ivSizeY(0),
+  ivNumTilesX(0)
+{}
+
+
+ExpandedStates2D::~ExpandedStates2D()
+{
+  release();
+}
+
+
+void
+ExpandedStates2D::resize(int min_x, int min_y, int max_x, int max_y)
+{
+  release();
+
+  if (max_x < min_x || max_y < min_y)
+  {
+    ivSizeX = ivSizeY = ivNumTilesX = 0;
+    return;
+  }
+
+  ivMinX = min_x;
+  ivMinY = min_y;
+  ivSizeX = max_x - min_x + 1;
+  ivSizeY = max_y - min_y + 1;
+  ivNumTilesX = (ivSizeX + cvTileMask) >> cvTileShift;
+  unsigned int num_tiles_y = (ivSizeY + cvTileMask) >> cvTileShift;
+  ivTiles.assign(ivNumTilesX * num_tiles_y, NULL);
+}
+
+
+void
+ExpandedStates2D::clear()
+{
+  std::vector<unsigned int>::const_iterator tile_iter;
+  for (tile_iter = ivUsedTiles.begin(); tile_iter != ivUsedTiles.end();
+       ++tile_iter)
+  {
+    memset(ivTiles[*tile_iter], 0, cvTileSize * sizeof(uint64_t));
+  }
+}
+
+
+uint64_t*
+ExpandedStates2D::allocateTile(unsigned int tile)
+{
+  uint64_t* bits = new uint64_t[cvTileSize];
+  memset(bits, 0, cvTileSize * sizeof(uint64_t));
+  ivTiles[tile] = bits;
+  ivUsedTiles.push_back(tile);
+  return bits;
+}
+
+
+void
+ExpandedStates2D::release()
+{
+  std::vector<unsigned int>::const_iterator tile_iter;
+  for (tile_iter = ivUsedTiles.begin(); tile_iter != ivUsedTiles.end();
+       ++tile_iter)
+  {
+    delete[] ivTiles[*tile_iter];
+  }
+  ivTiles.clear();
+  ivUsedTiles.clear();
+}
+
+
+ExpandedStates2D::const_iterator
+ExpandedStates2D::begin()
+const
+{
+  return const_iterator(this, 0);
+}
+
+
+ExpandedStates2D::const_iterator
+ExpandedStates2D::end()
+const
+{
+  return const_iterator(this, ivUsedTiles.size());
+}
+
+
+ExpandedStates2D::const_iterator::const_iterator()
+: ivpStates(NULL),
+  ivTilePos(0),
+  ivRow(0),
+  ivBits(0)
+{}
+
+
+ExpandedStates2D::const_iterator::const_iterator(
+    const ExpandedStates2D* states, size_t tile_pos)
+: ivpStates(states),
+  ivTilePos(tile_pos),
+  ivRow(0),
+  ivBits(0)
+{
+  if (ivTilePos < ivpStates->ivUsedTiles.size())
+  {
+    ivBits = ivpStates->ivTiles[ivpStates->ivUsedTiles[ivTilePos]][0];
+    seek();
+  }
+}
+
+
+void
+ExpandedStates2D::const_iterator::seek()
+{
+  const std::vector<unsigned int>& used = ivpStates->ivUsedTiles;
+  while (ivTilePos < used.size())
+  {
+    const uint64_t* bits = ivpStates->ivTiles[used[ivTilePos]];
+    while (ivBits == 0 && ivRow < cvTileMask)
+      ivBits = bits[++ivRow];
+
+    if (ivBits != 0)
+    {
+      unsigned int tile = used[ivTilePos];
+      int tile_x = tile % ivpStates->ivNumTilesX;
+      int tile_y = tile / ivpStates->ivNumTilesX;
+      ivCell.first = ivpStates->ivMinX + (tile_x << cvTileShift) +
+                     __builtin_ctzll(ivBits);
+      ivCell.second = ivpStates->ivMinY + (tile_y << cvTileShift) + ivRow;
+      return;
+    }
+
+    // continue with the next tile
+    ++ivTilePos;
+    ivRow = 0;
+    if (ivTilePos < used.size())
+      ivBits = ivpStates->ivTiles[used[ivTilePos]][0];
+  }
+}
+
+
+ExpandedStates2D::const_iterator&
+ExpandedStates2D::const_iterator::operator ++()
+{
+  // remove the lowest set bit (i.e. the current cell)
+  ivBits &= ivBits - 1;
+  seek();
+  return *this;
+}
+
+
+ExpandedStates2D::const_iterator
+ExpandedStates2D::const_iterator::operator ++(int)
+{
+  const_iterator tmp(*this);
+  ++(*this);
+  return tmp;
+}
+
+
+bool
+ExpandedStates2D::const_iterator::operator ==(const const_iterator& other)
+const
+{
+  if (ivTilePos != other.ivTilePos)
+    return false;
+  // all end iterators are equal
+  if (ivpStates == NULL || ivTilePos >= ivpStates->ivUsedTiles.size())
+    return true;
+  return ivRow == other.ivRow && ivBits == other.ivBits;
+}
+}
@@ -0,0 +1,217 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/FootPoseTracker.h>
+
+#include <algorithm>
+
+
+namespace footstep_planner
+{
+const double FootPoseTracker::cvRestDistance = 0.001;
+const double FootPoseTracker::cvRestAngle = 0.01;
+const double FootPoseTracker::cvMaxTransformAge = 1.0;
+
+
+FootPoseTracker::FootPoseTracker(const tf::TransformListener& listener,
+                                 const std::string& left_foot_id,
+                                 const std::string& right_foot_id,
+                                 const std::string& world_frame_id,
+                                 double rate, double settle_time)
+: ivTransformListener(listener),
+  ivIdFootLeft(left_foot_id),
+  ivIdFootRight(right_foot_id),
+  ivRate(rate),
+  ivSettleTime(settle_time),
+  ivIdWorldFrame(world_frame_id),
+  ivSettled(false),
+  ivSampled(false)
+{
+  ivThreadPtr.reset(
+    new boost::thread(boost::bind(&FootPoseTracker::run, this)));
+}
+
+
+FootPoseTracker::~FootPoseTracker()
+{
+  ivThreadPtr->interrupt();
+  ivThreadPtr->join();
+}
+
+
+void
+FootPoseTracker::setWorldFrame(const std::string& world_frame_id)
+{
+  boost::mutex::scoped_lock lock(ivLock);
+  if (world_frame_id == ivIdWorldFrame)
+    return;
+  ivIdWorldFrame = world_frame_id;
+  ivSettled = false;
+  ivRestSince = ros::Time();
+}
+
+
+void
+FootPoseTracker::invalidate()
+{
+  boost::mutex::scoped_lock lock(ivLock);
+  ivSettled = false;
+  ivRestSince = ros::Time();
+}
+
+
+bool
+FootPoseTracker::getSettledFeet(State* left, State* right, double timeout)
+const
+{
+  boost::mutex::scoped_lock lock(ivLock);
+  if (!ivSettled && timeout > 0.0)
+  {
+    boost::system_time deadline = boost::get_system_time() +
+        boost::posix_time::milliseconds(long(timeout * 1000));
+    while (!ivSettled)
+    {
+      if (!ivSettledCondition.timed_wait(lock, deadline))
+        break;
+    }
+  }
+  if (!ivSettled)
+    return false;
+
+  *left = ivSettledLeft;
+  *right = ivSettledRight;
+  return true;
+}
+
+
+void
+FootPoseTracker::run()
+{
+  boost::posix_time::milliseconds period(long(1000.0 / ivRate));
+  try
+  {
+    while (true)
+    {
+      boost::this_thread::interruption_point();
+
+      std::string world_frame_id;
+      {
+        boost::mutex::scoped_lock lock(ivLock);
+        world_frame_id = ivIdWorldFrame;
+      }
+
+      State left, right;
+      ros::Time stamp_left, stamp_right;
+      if (!lookupFoot(ivIdFootLeft, world_frame_id, LEFT, &left,
+                      &stamp_left) ||
+          !lookupFoot(ivIdFootRight, world_frame_id, RIGHT, &right,
+                      &stamp_right))
+      {
+        ivSampled = false;
+        boost::mutex::scoped_lock lock(ivLock);
+        ivSettled = false;
+        ivRestSince = ros::Time();
+      }
+      else if (!ivSampled || (stamp_left > ivLastStampLeft &&
+                              stamp_right > ivLastStampRight))
+      {
+        // only new transforms are samples: a stale tf (e.g. the robot's
+        // state publisher stopped) does not show the feet at rest
+        bool at_rest = ivSampled && atRest(ivLastLeft, left) &&
+                       atRest(ivLastRight, right);
+        ivSampled = true;
+        ivLastLeft = left;
+        ivLastRight = right;
+        ivLastStampLeft = stamp_left;
+        ivLastStampRight = stamp_right;
+        // the settle time is measured in the time of the transforms
+        ros::Time stamp = std::min(stamp_left, stamp_right);
+
+        boost::mutex::scoped_lock lock(ivLock);
+        if (!at_rest || world_frame_id != ivIdWorldFrame)
+        {
+          ivRestSince = ros::Time();
+          ivSettled = false;
+        }
+        else if (ivRestSince.isZero())
+        {
+          ivRestSince = stamp;
+        }
+        else if ((stamp - ivRestSince).toSec() >= ivSettleTime)
+        {
+          ivSettledLeft = left;
+          ivSettledRight = right;
+          if (!ivSettled)
+          {
+            ivSettled = true;
+            ivSettledCondition.notify_all();
+          }
+        }
+      }
+
+      boost::this_thread::sleep(period);
+    }
+  }
+  catch (const boost::thread_interrupted&)
+  {
+    // leave this thread
+  }
+}
+
+
+bool
+FootPoseTracker::lookupFoot(const std::string& foot_id,
+                            const std::string& world_frame_id, Leg leg,
+                            State* foot, ros::Time* stamp)
+{
+  tf::StampedTransform transform;
+  try
+  {
+    // latest available transform, i.e. no waiting
+    ivTransformListener.lookupTransform(world_frame_id, foot_id, ros::Time(0),
+                                        transform);
+  }
+  catch (const tf::TransformException& e)
+  {
+    ROS_DEBUG("Failed to obtain FootTransform from tf (%s)", e.what());
+    return false;
+  }
+  if ((ros::Time::now() - transform.stamp_).toSec() > cvMaxTransformAge)
+    return false;
+
+  foot->setX(transform.getOrigin().x());
+  foot->setY(transform.getOrigin().y());
+  foot->setTheta(tf::getYaw(transform.getRotation()));
+  foot->setLeg(leg);
+  *stamp = transform.stamp_;
+  return true;
+}
+
+
+bool
+FootPoseTracker::atRest(const State& last, const State& current)
+{
+  return (fabs(last.getX() - current.getX()) < cvRestDistance &&
+          fabs(last.getY() - current.getY()) < cvRestDistance &&
+          fabs(angles::shortest_angular_distance(last.getTheta(),
+                                                 current.getTheta())) <
+              cvRestAngle);
+}
+}
@@ -23,36 +23,40 @@
 
 namespace footstep_planner
 {
-FootstepNavigation::FootstepNavigation()
-: ivIdFootRight("/r_sole"),
+FootstepNavigation::FootstepNavigation(ros::NodeHandle nh,
+                                       ros::NodeHandle nh_private)
+: ivPlanner(nh_private),
+  ivIdFootRight("/r_sole"),
   ivIdFootLeft("/l_sole"),
   ivIdMapFrame("map"),
   ivExecutingFootsteps(false),
-  ivFootstepsExecution("footsteps_execution", true),
+  ivFootstepsExecution(nh, "footsteps_execution", true),
   ivExecutionShift(2),
   ivControlStepIdx(-1),
-  ivResetStepIdx(0)
+  ivResetStepIdx(0),
+  ivBackgroundReplanning(false),
+  ivReplanningLookahead(4),
+  ivReplanningRequested(false),
+  ivReplanningFailed(false),
+  ivReplanningStepIdx(0),
+  ivReplannedStepIdx(0),
+  ivExecutionStepIdx(0),
+  ivPathRevision(0),
+  ivReplanningRevision(0),
+  ivRepairMaxSteps(3),
+  ivPlanningHorizon(0.0),
+  ivFinalGoalPlanned(true),
+  ivPathReachesGoal(true),
+  ivReplannedPathReachesGoal(true)
 {
-  // private NodeHandle for parameters and private messages (debug / info)
-  ros::NodeHandle nh_private("~");
-  ros::NodeHandle nh_public;
-
   // service
   ivFootstepSrv =
-    nh_public.serviceClient<humanoid_nav_msgs::StepTargetService>(
+    nh.serviceClient<humanoid_nav_msgs::StepTargetService>(
       "footstep_srv");
   ivClipFootstepSrv =
-    nh_public.serviceClient<humanoid_nav_msgs::ClipFootstep>(
+    nh.serviceClient<humanoid_nav_msgs::ClipFootstep>(
       "clip_footstep_srv");
 
-  // subscribers
-  ivGridMapSub =
-    nh_public.subscribe<nav_msgs::OccupancyGrid>(
-      "map", 1, &FootstepNavigation::mapCallback, this);
-  ivGoalPoseSub =
-    nh_public.subscribe<geometry_msgs::PoseStamped>(
-      "goal", 1, &FootstepNavigation::goalPoseCallback, this);
-
   // read parameters from config file:
   nh_private.param("rfoot_frame_id", ivIdFootRight, ivIdFootRight);
   nh_private.param("lfoot_frame_id", ivIdFootLeft, ivIdFootLeft);
@@ -68,6 +72,15 @@ FootstepNavigation::FootstepNavigation()
 
   nh_private.param("feedback_frequency", ivFeedbackFrequency, 5.0);
   nh_private.param("safe_execution", ivSafeExecution, true);
+  nh_private.param("background_replanning", ivBackgroundReplanning, false);
+  nh_private.param("replanning_lookahead", ivReplanningLookahead, 4);
+  nh_private.param("repair_max_steps", ivRepairMaxSteps, ivRepairMaxSteps);
+
+  double foot_tracking_rate, foot_settle_time;
+  nh_private.param("foot_tracking_rate", foot_tracking_rate, 20.0);
+  nh_private.param("foot_settle_time", foot_settle_time, 0.2);
+  nh_private.param("start_timeout", ivStartTimeout, 1.0);
+  nh_private.param("planning_horizon", ivPlanningHorizon, 0.0);
 
   nh_private.param("foot/max/step/x", ivMaxStepX, 0.07);
   nh_private.param("foot/max/step/y", ivMaxStepY, 0.15);
@@ -102,66 +115,435 @@ FootstepNavigation::FootstepNavigation()
   }
   // insert first point again at the end!
   ivStepRange.push_back(ivStepRange[0]);
+
+  if (ivPlanningHorizon > 0.0)
+  {
+    // 2D paths are planned for the incircle of the foot (as for the
+    // PathCostHeuristic of the planner); only the 2D path is used
+    const environment_params& params = ivPlanner.ivEnvironmentParams;
+    double foot_incircle =
+      std::min((params.footsize_x / 2.0 -
+                std::abs(params.foot_origin_shift_x)),
+               (params.footsize_y / 2.0 -
+                std::abs(params.foot_origin_shift_y)));
+    ivRouteHeuristicPtr.reset(
+      new PathCostHeuristic(params.cell_size, params.num_angle_bins,
+                            params.step_cost, 0.0, ivMaxStepX,
+                            foot_incircle));
+    ROS_INFO("Receding horizon planning (horizon: %f m)", ivPlanningHorizon);
+  }
+
+  ivFootPoseTrackerPtr.reset(
+    new FootPoseTracker(ivTransformListener, ivIdFootLeft, ivIdFootRight,
+                        ivIdMapFrame, foot_tracking_rate, foot_settle_time));
+
+  // the checks of the execution thread only need the map (a
+  // PathCostHeuristic would be updated with each map)
+  environment_params execution_params = ivPlanner.ivEnvironmentParams;
+  execution_params.heuristic.reset(
+    new EuclideanHeuristic(execution_params.cell_size,
+                           execution_params.num_angle_bins));
+  ivExecutionEnvironmentPtr.reset(
+    new FootstepPlannerEnvironment(execution_params));
+
+  if (ivBackgroundReplanning && !ivSafeExecution)
+  {
+    ROS_WARN("Background replanning requires the safe execution. "
+             "Disabling background replanning.");
+    ivBackgroundReplanning = false;
+  }
+  if (ivBackgroundReplanning)
+  {
+    if (ivReplanningLookahead < 1)
+      ivReplanningLookahead = 1;
+    ivReplanningThreadPtr.reset(
+      new boost::thread(
+        boost::bind(&FootstepNavigation::replanningLoop, this)));
+  }
+
+  // subscribers (last, since the callbacks may be called right away when
+  // running as nodelet)
+  ivGridMapSub =
+    nh.subscribe<nav_msgs::OccupancyGrid>(
+      "map", 1, &FootstepNavigation::mapCallback, this);
+  ivGoalPoseSub =
+    nh.subscribe<geometry_msgs::PoseStamped>(
+      "goal", 1, &FootstepNavigation::goalPoseCallback, this);
 }
 
 
 FootstepNavigation::~FootstepNavigation()
-{}
+{
+  if (ivReplanningThreadPtr)
+  {
+    ivReplanningThreadPtr->interrupt();
+    ivReplanningThreadPtr->join();
+  }
+}
 
 
 bool
 FootstepNavigation::plan()
 {
-  if (!updateStart())
   {
-    ROS_ERROR("Start pose not accessible!");
+    boost::mutex::scoped_lock lock(ivPlannerLock);
+    if (!updateStart())
+    {
+      ROS_ERROR("Start pose not accessible!");
+      return false;
+    }
+    if (!updatePlanningGoal())
+      return false;
+
+    if (!ivPlanner.plan())
+    {
+      // path planning unsuccessful
+      return false;
+    }
+    takePlannerPath();
+  }
+
+  startExecution();
+  return true;
+}
+
+
+bool
+FootstepNavigation::replan()
+{
+  {
+    boost::mutex::scoped_lock lock(ivPlannerLock);
+    if (!updateStart())
+    {
+      ROS_ERROR("Start pose not accessible!");
+      return false;
+    }
+    if (!updatePlanningGoal())
+    {
+      ivExecutingFootsteps = false;
+      return false;
+    }
+
+    bool path_existed = ivPlanner.pathExists();
+
+    // calculate path by replanning (if no planning information exists
+    // this call is equal to ivPlanner.plan())
+    bool success = ivPlanner.replan();
+    if (!success && path_existed)
+    {
+      ROS_INFO("Replanning unsuccessful. Reseting previous planning "
+               "information.");
+      success = ivPlanner.plan();
+    }
+    if (!success)
+    {
+      // path planning unsuccessful
+      ivExecutingFootsteps = false;
+      return false;
+    }
+    takePlannerPath();
+  }
+
+  startExecution();
+  return true;
+}
+
+
+void
+FootstepNavigation::takePlannerPath()
+{
+  boost::mutex::scoped_lock lock(ivReplanningLock);
+  ivPath.assign(ivPlanner.getPathBegin(), ivPlanner.getPathEnd());
+  ivPathReachesGoal = ivFinalGoalPlanned;
+  ivExecutionStepIdx = 0;
+  ++ivPathRevision;
+  // plans requested for a previous path are obsolete
+  ivReplanningRequested = false;
+  ivReplanningFailed = false;
+  ivReplannedPath.clear();
+}
+
+
+bool
+FootstepNavigation::requestReplanning(bool from_path_end)
+{
+  boost::mutex::scoped_lock lock(ivReplanningLock);
+
+  size_t step_idx;
+  if (from_path_end)
+  {
+    step_idx = ivPath.size() - 1;
+  }
+  else
+  {
+    step_idx = ivExecutionStepIdx + ivReplanningLookahead;
+    if (step_idx + 1 >= ivPath.size())
+      return false;
+  }
+  if (step_idx < 1)
     return false;
+
+  // the robot keeps walking on the current path until the new one starts
+  {
+    boost::mutex::scoped_lock environment_lock(ivExecutionEnvironmentLock);
+    for (size_t i = ivExecutionStepIdx + 1; i <= step_idx; ++i)
+    {
+      if (ivExecutionEnvironmentPtr->occupied(ivPath[i]))
+        return false;
+    }
   }
 
-  if (ivPlanner.plan())
+  const State& support = ivPath[step_idx];
+  const State& other = ivPath[step_idx - 1];
+  if (support.getLeg() == other.getLeg())
+    return false;
+  if (support.getLeg() == LEFT)
   {
-    startExecution();
-    return true;
+    ivReplanningStartLeft = support;
+    ivReplanningStartRight = other;
   }
-  // path planning unsuccessful
-  return false;
+  else
+  {
+    ivReplanningStartLeft = other;
+    ivReplanningStartRight = support;
+  }
+  ivReplanningStepIdx = step_idx;
+  ivReplanningRevision = ivPathRevision;
+  ivReplanningRequested = true;
+  ivReplanningFailed = false;
+  ivReplannedPath.clear();
+  ivReplanningCondition.notify_one();
+
+  return true;
 }
 
 
 bool
-FootstepNavigation::replan()
+FootstepNavigation::repairPath(const State& support_foot, size_t first_idx)
 {
-  if (!updateStart())
+  if (ivRepairMaxSteps <= 0)
+    return false;
+
+  std::vector<State> repair;
+  int reconnect_idx;
+  {
+    // not on the planner, which may be busy with a plan in the background
+    boost::mutex::scoped_lock environment_lock(ivExecutionEnvironmentLock);
+    reconnect_idx = ivExecutionEnvironmentPtr->repairPath(
+      support_foot, ivPath, first_idx, ivRepairMaxSteps, &repair);
+  }
+  if (reconnect_idx < 0)
   {
-    ROS_ERROR("Start pose not accessible!");
+    ROS_INFO("Path cannot be reconnected to within %i footsteps.",
+             ivRepairMaxSteps);
     return false;
   }
+  ROS_INFO("Path repaired: reconnecting to step %i with %zu footstep(s).",
+           reconnect_idx, repair.size() + 1);
+
+  std::vector<State> path;
+  path.reserve(1 + repair.size() + ivPath.size() - reconnect_idx);
+  path.push_back(support_foot);
+  path.insert(path.end(), repair.begin(), repair.end());
+  path.insert(path.end(), ivPath.begin() + reconnect_idx, ivPath.end());
+
+  boost::mutex::scoped_lock lock(ivReplanningLock);
+  ivPath.swap(path);
+  ivExecutionStepIdx = 0;
+  ++ivPathRevision;
+  // a plan calculated in the background refers to the previous path
+  ivReplannedPath.clear();
 
-  bool path_existed = ivPlanner.pathExists();
+  return true;
+}
 
-  // calculate path by replanning (if no planning information exists
-  // this call is equal to ivPlanner.plan())
-  if (ivPlanner.replan())
+
+void
+FootstepNavigation::replanningLoop()
+{
+  while (true)
   {
-    startExecution();
+    size_t step_idx;
+    unsigned int revision;
+    State start_left, start_right;
+    nav_msgs::OccupancyGridConstPtr occupancy_map;
+    {
+      boost::mutex::scoped_lock lock(ivReplanningLock);
+      try
+      {
+        while (true)
+        {
+          {
+            boost::mutex::scoped_lock map_lock(ivPendingMapLock);
+            occupancy_map.swap(ivPendingMap);
+          }
+          if (occupancy_map || ivReplanningRequested)
+            break;
+          ivReplanningCondition.wait(lock);
+        }
+      }
+      catch (const boost::thread_interrupted&)
+      {
+        // leave this thread
+        return;
+      }
+      if (!occupancy_map)
+      {
+        ivReplanningRequested = false;
+        step_idx = ivReplanningStepIdx;
+        revision = ivReplanningRevision;
+        start_left = ivReplanningStartLeft;
+        start_right = ivReplanningStartRight;
+      }
+    }
+    // a new map is applied first, it may request another plan
+    if (occupancy_map)
+    {
+      applyMap(occupancy_map);
+      continue;
+    }
+
+    ROS_INFO("Replanning in the background from step %zu.", step_idx);
+
+    std::vector<State> path;
+    boost::mutex::scoped_lock planner_lock(ivPlannerLock);
+    if (ivPlanner.setStart(start_left, start_right) && updatePlanningGoal() &&
+        ivPlanner.replan())
+    {
+      path.assign(ivPlanner.getPathBegin(), ivPlanner.getPathEnd());
+    }
+
+    boost::mutex::scoped_lock lock(ivReplanningLock);
+    // discard the plan if a newer one has been requested or a new map has
+    // been received in the meantime
+    if (ivReplanningRequested)
+      continue;
+    {
+      boost::mutex::scoped_lock map_lock(ivPendingMapLock);
+      if (ivPendingMap)
+        continue;
+    }
+    // ivPath has been replaced or repaired in the meantime: plan again
+    // from the current path
+    if (revision != ivPathRevision)
+    {
+      lock.unlock();
+      requestReplanning();
+      continue;
+    }
+    if (path.empty())
+    {
+      ivReplanningFailed = true;
+    }
+    else
+    {
+      ivReplannedPath.swap(path);
+      ivReplannedStepIdx = step_idx;
+      ivReplannedPathReachesGoal = ivFinalGoalPlanned;
+    }
+  }
+}
+
+
+bool
+FootstepNavigation::updatePlanningGoal()
+{
+  if (!ivRouteHeuristicPtr)
     return true;
+
+  const State left = ivPlanner.getStartFootLeft();
+  const State right = ivPlanner.getStartFootRight();
+  double x = (left.getX() + right.getX()) / 2.0;
+  double y = (left.getY() + right.getY()) / 2.0;
+
+  std::vector<std::pair<double, double> > route;
+  if (!ivRouteHeuristicPtr->calculatePath2D(x, y, ivFinalGoal.getX(),
+                                            ivFinalGoal.getY(), &route))
+  {
+    ROS_WARN("No 2D path to the goal, planning footsteps to the goal.");
+    ivFinalGoalPlanned = true;
+    return ivPlanner.setGoal(ivFinalGoal.getX(), ivFinalGoal.getY(),
+                             ivFinalGoal.getTheta());
   }
-  else if (path_existed)
+
+  // follow the 2D path up to the horizon
+  double dist = 0.0;
+  size_t i = 1;
+  for (; i < route.size(); ++i)
+  {
+    dist += euclidean_distance(route[i - 1].first, route[i - 1].second,
+                               route[i].first, route[i].second);
+    if (dist > ivPlanningHorizon)
+      break;
+  }
+  if (i >= route.size())
   {
-    ROS_INFO("Replanning unsuccessful. Reseting previous planning "
-             "information.");
-    if (ivPlanner.plan())
+    ivFinalGoalPlanned = true;
+    return ivPlanner.setGoal(ivFinalGoal.getX(), ivFinalGoal.getY(),
+                             ivFinalGoal.getTheta());
+  }
+
+  // intermediate goal oriented along the 2D path (moved back along the path
+  // if the feet do not fit)
+  const size_t direction_cells = 5;
+  for (; i > 0; --i)
+  {
+    size_t ahead = std::min(i + direction_cells, route.size() - 1);
+    double theta = atan2(route[ahead].second - route[i].second,
+                         route[ahead].first - route[i].first);
+    if (ivPlanner.setGoal(route[i].first, route[i].second, theta))
     {
-      startExecution();
+      ROS_INFO("Intermediate goal (%f, %f, %f) on the way to (%f, %f, %f).",
+               route[i].first, route[i].second, theta,
+               ivFinalGoal.getX(), ivFinalGoal.getY(),
+               ivFinalGoal.getTheta());
+      ivFinalGoalPlanned = false;
       return true;
     }
   }
-  // path planning unsuccessful
-  ivExecutingFootsteps = false;
+
   return false;
 }
 
 
+bool
+FootstepNavigation::switchToReplannedPath(size_t* step_idx)
+{
+  {
+    boost::mutex::scoped_lock lock(ivReplanningLock);
+    ivExecutionStepIdx = *step_idx;
+    if (ivReplanningFailed)
+    {
+      ivReplanningFailed = false;
+      return false;
+    }
+    // no new plan or its start not reached yet
+    if (ivReplannedPath.empty() || ivReplannedStepIdx > *step_idx)
+      return true;
+
+    if (ivReplannedStepIdx == *step_idx)
+    {
+      ROS_INFO("Switching to the path replanned in the background.");
+      ivPath.swap(ivReplannedPath);
+      ivPathReachesGoal = ivReplannedPathReachesGoal;
+      ++ivPathRevision;
+      ivReplannedPath.clear();
+      *step_idx = 0;
+      ivExecutionStepIdx = 0;
+      return true;
+    }
+
+    ROS_INFO("Path replanned in the background starts at step %zu which "
+             "has already been passed (now at step %zu).",
+             ivReplannedStepIdx, *step_idx);
+    ivReplannedPath.clear();
+  }
+
+  // try again from further ahead
+  return requestReplanning();
+}
+
+
 void
 FootstepNavigation::startExecution()
 {
@@ -182,7 +564,7 @@ FootstepNavigation::startExecution()
 void
 FootstepNavigation::executeFootsteps()
 {
-  if (ivPlanner.getPathSize() <= 1)
+  if (ivPath.size() <= 1)
     return;
 
   // lock this thread
@@ -191,22 +573,25 @@ FootstepNavigation::executeFootsteps()
   ROS_INFO("Start walking towards the goal.");
 
   humanoid_nav_msgs::StepTarget step;
-  humanoid_nav_msgs::StepTargetService step_srv;
+  std::vector<humanoid_nav_msgs::StepTarget> planned_steps;
 
   tf::Transform from;
   std::string support_foot_id;
 
-  // calculate and perform relative footsteps until goal is reached
-  state_iter_t to_planned = ivPlanner.getPathBegin();
-  if (to_planned == ivPlanner.getPathEnd())
-  {
-    ROS_ERROR("No plan available. Return.");
-    return;
-  }
+  // footsteps are performed by a separate thread; the next footstep is
+  // prepared while the robot performs the current one
+  ivStepFinishedTime = ros::Time::now();
+  // time between the end of a footstep and the start of the next one
+  ros::Duration idle_time(0.0);
+  int num_steps = 0;
 
-  const State* from_planned = to_planned.base();
-  to_planned++;
-  while (to_planned != ivPlanner.getPathEnd())
+  // calculate and perform relative footsteps until goal is reached
+  size_t step_idx = 0;
+  // the extension of the path has been requested (receding horizon)
+  bool extension_requested = false;
+  // the path has been repaired at the current support foot
+  bool repaired = false;
+  while (true)
   {
     try
     {
@@ -214,28 +599,106 @@ FootstepNavigation::executeFootsteps()
     }
     catch (const boost::thread_interrupted&)
     {
+      waitForFootstep();
       // leave this thread
       return;
     }
 
+    // continue on a path planned in the background if its start is reached
+    if (ivBackgroundReplanning && !switchToReplannedPath(&step_idx))
+    {
+      ROS_INFO("Replanning in the background failed. Replanning "
+               "necessary.");
+
+      waitForFootstep();
+      replan();
+      // leave the thread
+      return;
+    }
+    if (step_idx == 0)
+    {
+      extension_requested = false;
+
+      // check all planned footsteps of the (new) path at once
+      planned_steps.clear();
+      if (!getFootstepsFromPath(ivPath.front(), 1, planned_steps))
+      {
+        ROS_INFO("Path cannot be performed. Replanning necessary.");
+
+        waitForFootstep();
+        replan();
+        // leave the thread
+        return;
+      }
+    }
+
+    if (step_idx + 1 >= ivPath.size())
+    {
+      if (ivPathReachesGoal)
+        break;
+      if (extension_requested)
+      {
+        // wait for the extension planned in the background
+        ros::Duration(0.05).sleep();
+        continue;
+      }
+
+      ROS_INFO("Intermediate goal reached. Planning the next part of the "
+               "path.");
+      waitForFootstep();
+      replan();
+      // leave the thread
+      return;
+    }
+
+    // plan the extension of the path in the background before the end of
+    // the path is reached
+    if (ivBackgroundReplanning && !ivPathReachesGoal && !extension_requested &&
+        step_idx + 1 + ivReplanningLookahead >= ivPath.size())
+    {
+      extension_requested = requestReplanning(true);
+    }
+
+    const State* from_planned = &ivPath[step_idx];
+    const State* to_planned = &ivPath[step_idx + 1];
+
     if (from_planned->getLeg() == RIGHT)
       support_foot_id = ivIdFootRight;
     else // support_foot = LLEG
       support_foot_id = ivIdFootLeft;
 
-    // try to get real placement of the support foot
-    if (getFootTransform(support_foot_id, ivIdMapFrame, ros::Time::now(),
+    // the support foot is placed by the footstep currently performed
+    waitForFootstep();
+
+    // try to get real placement of the support foot (at the end of the
+    // previous footstep, i.e. without waiting for a newer transform)
+    if (getFootTransform(support_foot_id, ivIdMapFrame, ivStepFinishedTime,
                          ros::Duration(0.5), &from))
     {
       // calculate relative step and check if it can be performed
       if (getFootstep(from, *from_planned, *to_planned, &step))
       {
-        step_srv.request.step = step;
-        ivFootstepSrv.call(step_srv);
+        idle_time += ros::Time::now() - ivStepFinishedTime;
+        ++num_steps;
+        repaired = false;
+        ivStepThreadPtr.reset(
+          new boost::thread(&FootstepNavigation::performFootstep, this,
+                            step));
       }
-      // ..if it cannot be performed initialize replanning
+      // ..if it cannot be performed try to reconnect to the path within a
+      // few footsteps and otherwise initialize replanning
       else
       {
+        State support(from.getOrigin().x(), from.getOrigin().y(),
+                      tf::getYaw(from.getRotation()), from_planned->getLeg());
+        if (!repaired && repairPath(support, step_idx + 1))
+        {
+          // the repaired path starts at the support foot
+          repaired = true;
+          step_idx = 0;
+          continue;
+        }
+
         ROS_INFO("Footstep cannot be performed. Replanning necessary.");
 
         replan();
@@ -247,23 +710,56 @@ FootstepNavigation::executeFootsteps()
     {
       // if the support foot could not be received wait and try again
       ros::Duration(0.5).sleep();
+      ivStepFinishedTime = ros::Time::now();
       continue;
     }
 
-    from_planned = to_planned.base();
-    to_planned++;
+    ++step_idx;
   }
+  waitForFootstep();
   ROS_INFO("Succeeded walking to the goal.\n");
+  if (num_steps > 0)
+  {
+    ROS_INFO("Mean time between footsteps: %f s",
+             idle_time.toSec() / num_steps);
+  }
 
   // free the lock
   ivExecutingFootsteps = false;
 }
 
 
+void
+FootstepNavigation::performFootstep(humanoid_nav_msgs::StepTarget step)
+{
+  humanoid_nav_msgs::StepTargetService step_srv;
+  step_srv.request.step = step;
+  if (!ivFootstepSrv.call(step_srv))
+    ROS_WARN("Footstep service call failed.");
+
+  ivStepFinishedTime = ros::Time::now();
+  // the feet have to settle after the step
+  ivFootPoseTrackerPtr->invalidate();
+}
+
+
+void
+FootstepNavigation::waitForFootstep()
+{
+  if (!ivStepThreadPtr)
+    return;
+
+  // a footstep in progress cannot be aborted
+  boost::this_thread::disable_interruption no_interruption;
+  ivStepThreadPtr->join();
+  ivStepThreadPtr.reset();
+}
+
+
 void
 FootstepNavigation::executeFootstepsFast()
 {
-  if (ivPlanner.getPathSize() <= 1)
+  if (ivPath.size() <= 1)
 	return;
 
   // lock the planning and execution process
@@ -274,7 +770,7 @@ FootstepNavigation::executeFootstepsFast()
 
   humanoid_nav_msgs::ExecFootstepsGoal goal;
   State support_leg;
-  if (ivPlanner.getPathBegin()->getLeg() == RIGHT)
+  if (ivPath.front().getLeg() == RIGHT)
     support_leg = ivPlanner.getStartFootRight();
   else // leg == LEFT
     support_leg = ivPlanner.getStartFootLeft();
@@ -317,7 +813,15 @@ FootstepNavigation::doneCallback(
 	const actionlib::SimpleClientGoalState& state,
 	const humanoid_nav_msgs::ExecFootstepsResultConstPtr& result)
 {
-	if (state == actionlib::SimpleClientGoalState::SUCCEEDED)
+	if (state == actionlib::SimpleClientGoalState::SUCCEEDED && !ivPathReachesGoal)
+	{
+	  ROS_INFO("Intermediate goal reached. Planning the next part of the "
+	           "path.");
+	  ivExecutingFootsteps = false;
+	  replan();
+	  return;
+	}
+	else if (state == actionlib::SimpleClientGoalState::SUCCEEDED)
 		ROS_INFO("Succeeded walking to the goal.");
 	else if (state == actionlib::SimpleClientGoalState::PREEMPTED)
 		ROS_INFO("Preempted walking to the goal.");
@@ -342,10 +846,11 @@ FootstepNavigation::feedbackCallback(
 	// everything is ok
 	if (executed_steps_idx == ivControlStepIdx)
     return;
+	// the feet have to settle after the executed step
+	ivFootPoseTrackerPtr->invalidate();
 
 	// get planned foot placement
-  const State& planned = *(ivPlanner.getPathBegin() + ivControlStepIdx + 1 +
-                           ivResetStepIdx);
+  const State& planned = ivPath[ivControlStepIdx + 1 + ivResetStepIdx];
   // get executed foot placement
   tf::Transform executed_tf;
   std::string foot_id;
@@ -398,14 +903,28 @@ FootstepNavigation::feedbackCallback(
 
     humanoid_nav_msgs::ExecFootstepsGoal goal;
     // try to reach the calculated path
-    if (getFootstepsFromPath(executed, executed_steps_idx + ivResetStepIdx,
-                             goal.footsteps))
+    bool path_reachable =
+      getFootstepsFromPath(executed, executed_steps_idx + ivResetStepIdx,
+                           goal.footsteps);
+    if (path_reachable)
     {
       ROS_INFO("Try to reach calculated path.");
-
-      goal.feedback_frequency = ivFeedbackFrequency;
       // adjust the internal counters
       ivResetStepIdx += ivControlStepIdx + 1;
+    }
+    // ..otherwise try to reconnect to it within a few footsteps
+    else if (repairPath(executed, executed_steps_idx + ivResetStepIdx))
+    {
+      // the repaired path starts at the executed footstep
+      goal.footsteps.clear();
+      path_reachable = getFootstepsFromPath(ivPath.front(), 1,
+                                            goal.footsteps);
+      ivResetStepIdx = 0;
+    }
+
+    if (path_reachable)
+    {
+      goal.feedback_frequency = ivFeedbackFrequency;
       ivControlStepIdx = 0;
 
       // restart the footstep execution
@@ -473,6 +992,22 @@ void
 FootstepNavigation::mapCallback(
   const nav_msgs::OccupancyGridConstPtr& occupancy_map)
 {
+  ivIdMapFrame = occupancy_map->header.frame_id;
+  ivFootPoseTrackerPtr->setWorldFrame(ivIdMapFrame);
+
+  // the planner may be busy with a plan in the background: the replanning
+  // thread applies the map after it (a newer map replaces a pending one)
+  if (ivBackgroundReplanning)
+  {
+    {
+      boost::mutex::scoped_lock map_lock(ivPendingMapLock);
+      ivPendingMap = occupancy_map;
+    }
+    boost::mutex::scoped_lock lock(ivReplanningLock);
+    ivReplanningCondition.notify_one();
+    return;
+  }
+
   // stop execution if an execution was performed
   if (ivExecutingFootsteps)
   {
@@ -488,17 +1023,66 @@ FootstepNavigation::mapCallback(
     }
   }
 
-  gridmap_2d::GridMap2DPtr map(new gridmap_2d::GridMap2D(occupancy_map));
-  ivIdMapFrame = map->getFrameID();
-
   // updates the map and starts replanning if necessary
-  if (ivPlanner.updateMap(map))
+  bool replanning_necessary;
+  {
+    boost::mutex::scoped_lock lock(ivPlannerLock);
+    // the new map records its changes to the planner's one (see
+    // PathCostHeuristic::updateMap())
+    replanning_necessary = updateMap(
+      gridmap_2d::GridMap2DCache::get(occupancy_map, ivPlanner.getMap()));
+  }
+  if (replanning_necessary)
   {
     replan();
   }
 }
 
 
+void
+FootstepNavigation::applyMap(
+  const nav_msgs::OccupancyGridConstPtr& occupancy_map)
+{
+  bool replanning_necessary;
+  {
+    boost::mutex::scoped_lock lock(ivPlannerLock);
+    replanning_necessary = updateMap(
+      gridmap_2d::GridMap2DCache::get(occupancy_map, ivPlanner.getMap()));
+  }
+  if (!replanning_necessary)
+    return;
+
+  // keep walking while a new path is planned in the background
+  if (ivExecutingFootsteps)
+  {
+    if (requestReplanning())
+      return;
+
+    ROS_INFO("Replanning in the background not possible. Stopping the "
+             "execution.");
+    ivFootstepExecutionPtr->interrupt();
+    ivFootstepExecutionPtr->join();
+  }
+  replan();
+}
+
+
+bool
+FootstepNavigation::updateMap(const gridmap_2d::GridMap2DConstPtr& map)
+{
+  bool replanning_necessary = ivPlanner.updateMap(map);
+  // the planner's map may be a copy with another distance map depth
+  const gridmap_2d::GridMap2DConstPtr& planner_map = ivPlanner.getMap();
+  if (ivRouteHeuristicPtr)
+    ivRouteHeuristicPtr->updateMap(planner_map);
+
+  boost::mutex::scoped_lock lock(ivExecutionEnvironmentLock);
+  ivExecutionEnvironmentPtr->updateMap(planner_map);
+
+  return replanning_necessary;
+}
+
+
 bool
 FootstepNavigation::setGoal(const geometry_msgs::PoseStampedConstPtr goal_pose)
 {
@@ -511,6 +1095,9 @@ FootstepNavigation::setGoal(const geometry_msgs::PoseStampedConstPtr goal_pose)
 bool
 FootstepNavigation::setGoal(float x, float y, float theta)
 {
+  boost::mutex::scoped_lock lock(ivPlannerLock);
+  ivFinalGoal = State(x, y, theta, NOLEG);
+  ivFinalGoalPlanned = true;
 	return ivPlanner.setGoal(x, y, theta);
 }
 
@@ -518,22 +1105,21 @@ FootstepNavigation::setGoal(float x, float y, float theta)
 bool
 FootstepNavigation::updateStart()
 {
-  ros::Duration(0.5).sleep();
-
-  tf::Transform foot_left, foot_right;
+  State left, right;
+  // usually the feet have already settled, i.e. no waiting is necessary
+  if (!ivFootPoseTrackerPtr->getSettledFeet(&left, &right, ivStartTimeout))
   {
+    ROS_WARN("Feet did not settle within %f s, using the latest foot poses "
+             "from tf.", ivStartTimeout);
+
+    ros::Duration(0.5).sleep();
+
+    tf::Transform foot_left, foot_right;
     // get real placement of the feet
-	  if (!getFootTransform(ivIdFootLeft, ivIdMapFrame, ros::Time::now(),
-      		                ros::Duration(0.5), &foot_left))
-	  {
-	    if (ivPlanner.pathExists())
-	    {
-	      ivExecutingFootsteps = false;
-	    }
-	    return false;
-	  }
-    if (!getFootTransform(ivIdFootRight, ivIdMapFrame, ros::Time::now(),
-    		                  ros::Duration(0.5), &foot_right))
+    if (!getFootTransform(ivIdFootLeft, ivIdMapFrame, ros::Time::now(),
+                          ros::Duration(0.5), &foot_left) ||
+        !getFootTransform(ivIdFootRight, ivIdMapFrame, ros::Time::now(),
+                          ros::Duration(0.5), &foot_right))
     {
       if (ivPlanner.pathExists())
       {
@@ -541,11 +1127,11 @@ FootstepNavigation::updateStart()
       }
       return false;
     }
+    left = State(foot_left.getOrigin().x(), foot_left.getOrigin().y(),
+                 tf::getYaw(foot_left.getRotation()), LEFT);
+    right = State(foot_right.getOrigin().x(), foot_right.getOrigin().y(),
+                  tf::getYaw(foot_right.getRotation()), RIGHT);
   }
-  State left(foot_left.getOrigin().x(), foot_left.getOrigin().y(),
-  		       tf::getYaw(foot_left.getRotation()), LEFT);
-  State right(foot_right.getOrigin().x(), foot_right.getOrigin().y(),
-              tf::getYaw(foot_right.getRotation()), RIGHT);
 
   ROS_INFO("Robot standing at (%f, %f, %f, %i) (%f, %f, %f, %i).",
 		       left.getX(), left.getY(), left.getTheta(), left.getLeg(),
@@ -639,13 +1225,13 @@ FootstepNavigation::getFootstepsFromPath(
 {
   humanoid_nav_msgs::StepTarget footstep;
 
-  state_iter_t to_planned = ivPlanner.getPathBegin() + starting_step_num - 1;
+  state_iter_t to_planned = ivPath.begin() + starting_step_num - 1;
   tf::Pose last(tf::createQuaternionFromYaw(current_support_leg.getTheta()),
                 tf::Point(current_support_leg.getX(), current_support_leg.getY(),
                           0.0));
   const State* from_planned = to_planned.base();
   to_planned++;
-  for (; to_planned != ivPlanner.getPathEnd(); to_planned++)
+  for (; to_planned != ivPath.end(); to_planned++)
   {
     if (getFootstep(last, *from_planned, *to_planned, &footstep))
     {
@@ -23,22 +23,21 @@
 
 
 using gridmap_2d::GridMap2D;
+using gridmap_2d::GridMap2DConstPtr;
 using gridmap_2d::GridMap2DPtr;
+using gridmap_2d::GridMap2DCache;
 
 
 namespace footstep_planner
 {
-FootstepPlanner::FootstepPlanner()
+FootstepPlanner::FootstepPlanner(ros::NodeHandle nh_private)
 : ivStartPoseSetUp(false),
   ivGoalPoseSetUp(false),
   ivLastMarkerMsgSize(0),
   ivPathCost(0),
-  ivMarkerNamespace("")
+  ivMarkerNamespace(""),
+  ivPlanAnytimeServer(NULL)
 {
-  // private NodeHandle for parameters and private messages (debug / info)
-  ros::NodeHandle nh_private("~");
-  ros::NodeHandle nh_public;
-
   // ..publishers
   ivExpandedStatesVisPub = nh_private.advertise<
       sensor_msgs::PointCloud>("expanded_states", 1);
@@ -72,6 +71,7 @@ FootstepPlanner::FootstepPlanner()
   nh_private.param("diff_angle_cost", diff_angle_cost, 0.0);
 
   nh_private.param("planner_type", ivPlannerType, std::string("ARAPlanner"));
+  nh_private.param("open_list", ivOpenListType, std::string("BucketQueue"));
   nh_private.param("search_until_first_solution", ivSearchUntilFirstSolution,
                    false);
   nh_private.param("allocated_time", ivMaxSearchTime, 7.0);
@@ -82,6 +82,9 @@ FootstepPlanner::FootstepPlanner()
                    20);
   nh_private.param("random_node_dist", ivEnvironmentParams.random_node_distance,
                    1.0);
+  nh_private.param("random_seed", ivEnvironmentParams.random_seed, 0);
+  int num_local_search_workers;
+  nh_private.param("local_search_workers", num_local_search_workers, 4);
 
   // footstep settings
   nh_private.param("foot/size/x", ivEnvironmentParams.footsize_x, 0.16);
@@ -109,6 +112,38 @@ FootstepPlanner::FootstepPlanner()
                    ivEnvironmentParams.max_inverse_footstep_theta,
                    -0.3);
 
+  // distance map with 32 (float), 16 or 8 bits per cell, see
+  // gridmap_2d::GridMap2D::setDistanceMapDepth()
+  int distance_map_depth;
+  nh_private.param("distance_map_depth", distance_map_depth, 32);
+  nh_private.param("distance_map_max_distance", ivDistanceMapMaxDistance, 0.5);
+  if (distance_map_depth == 16)
+    ivDistanceMapDepth = CV_16U;
+  else if (distance_map_depth == 8)
+    ivDistanceMapDepth = CV_8U;
+  else
+  {
+    if (distance_map_depth != 32)
+      ROS_ERROR("distance_map_depth %d not supported (32, 16 or 8), using "
+                "32.", distance_map_depth);
+    ivDistanceMapDepth = CV_32F;
+  }
+  // distances saturate at the maximum, the collision check needs them up to
+  // the circumcircle of the foot
+  double foot_circumcircle =
+    sqrt(pow(ivEnvironmentParams.footsize_x / 2.0 +
+             std::abs(ivEnvironmentParams.foot_origin_shift_x), 2) +
+         pow(ivEnvironmentParams.footsize_y / 2.0 +
+             std::abs(ivEnvironmentParams.foot_origin_shift_y), 2));
+  if (ivDistanceMapDepth != CV_32F &&
+      ivDistanceMapMaxDistance <= foot_circumcircle)
+  {
+    ROS_ERROR("distance_map_max_distance %f has to be larger than the foot's "
+              "circumcircle %f, using a 32 bit distance map.",
+              ivDistanceMapMaxDistance, foot_circumcircle);
+    ivDistanceMapDepth = CV_32F;
+  }
+
   // footstep discretization
   XmlRpc::XmlRpcValue footsteps_x;
   XmlRpc::XmlRpcValue footsteps_y;
@@ -245,7 +280,9 @@ FootstepPlanner::FootstepPlanner()
   // set up planner
   if (ivPlannerType == "ARAPlanner" ||
       ivPlannerType == "ADPlanner"  ||
-      ivPlannerType == "RSTARPlanner" )
+      ivPlannerType == "RSTARPlanner" ||
+      ivPlannerType == "NativeARAPlanner" ||
+      ivPlannerType == "NativeRStarPlanner")
   {
     ROS_INFO_STREAM("Planning with " << ivPlannerType);
   }
@@ -255,6 +292,37 @@ FootstepPlanner::FootstepPlanner()
                      "untested.");
     exit(1);
   }
+  if ((ivPlannerType == "NativeARAPlanner" ||
+       ivPlannerType == "NativeRStarPlanner") &&
+      ivOpenListType != "BucketQueue" && ivOpenListType != "DAryHeap")
+  {
+    ROS_ERROR_STREAM("Open list "<< ivOpenListType <<" not available.");
+    exit(1);
+  }
+  if (ivPlannerType == "NativeRStarPlanner")
+  {
+    // the PathCostHeuristic is only valid towards the start / goal, R* needs
+    // the heuristic between arbitrary states (from several threads)
+    if (heuristic_type == "PathCostHeuristic")
+    {
+      ROS_ERROR("The NativeRStarPlanner needs the EuclideanHeuristic or the "
+                "EuclStepCostHeuristic.");
+      exit(1);
+    }
+    if (num_local_search_workers < 1)
+    {
+      ROS_ERROR("local_search_workers has to be at least 1.");
+      exit(1);
+    }
+    // the workers share the map, the footstep set and the heuristic
+    for (int i = 0; i < num_local_search_workers; ++i)
+    {
+      ivWorkerEnvironments.push_back(
+          boost::shared_ptr<FootstepPlannerEnvironment>(
+              new FootstepPlannerEnvironment(ivEnvironmentParams)));
+    }
+    ROS_INFO("Local searches of R* on %d workers", num_local_search_workers);
+  }
   if (ivEnvironmentParams.forward_search)
   {
     ROS_INFO_STREAM("Search direction: forward planning");
@@ -296,6 +364,44 @@ FootstepPlanner::setPlanner()
     //          p->set_eps_step(1.0);
     ivPlannerPtr.reset(p);
   }
+  else if (ivPlannerType == "NativeARAPlanner")
+  {
+    if (ivOpenListType == "DAryHeap")
+    {
+      ivPlannerPtr.reset(
+          new NativeARAPlanner<FootstepPlannerEnvironment, DAryHeap<4> >(
+              ivPlannerEnvironmentPtr.get(),
+              ivEnvironmentParams.forward_search));
+    }
+    else
+    {
+      ivPlannerPtr.reset(
+          new NativeARAPlanner<FootstepPlannerEnvironment, BucketQueue>(
+              ivPlannerEnvironmentPtr.get(),
+              ivEnvironmentParams.forward_search));
+    }
+  }
+  else if (ivPlannerType == "NativeRStarPlanner")
+  {
+    std::vector<FootstepPlannerEnvironment*> workers;
+    for (size_t i = 0; i < ivWorkerEnvironments.size(); ++i)
+      workers.push_back(ivWorkerEnvironments[i].get());
+
+    if (ivOpenListType == "DAryHeap")
+    {
+      ivPlannerPtr.reset(
+          new NativeRStarPlanner<FootstepPlannerEnvironment, DAryHeap<4> >(
+              ivPlannerEnvironmentPtr.get(), workers,
+              ivEnvironmentParams.forward_search));
+    }
+    else
+    {
+      ivPlannerPtr.reset(
+          new NativeRStarPlanner<FootstepPlannerEnvironment, BucketQueue>(
+              ivPlannerEnvironmentPtr.get(), workers,
+              ivEnvironmentParams.forward_search));
+    }
+  }
   //        else if (ivPlannerType == "ANAPlanner")
   //        	ivPlannerPtr.reset(new anaPlanner(ivPlannerEnvironmentPtr.get(),
   //        	                                  ivForwardSearch));
@@ -345,11 +451,30 @@ FootstepPlanner::run()
   ivPlannerPtr->set_initialsolution_eps(ivInitialEpsilon);
   ivPlannerPtr->set_search_mode(ivSearchUntilFirstSolution);
 
+  // stream the intermediate solutions to a running planning action
+  boost::shared_ptr<NativeARAPlannerBase> native_planner =
+      boost::dynamic_pointer_cast<NativeARAPlannerBase>(ivPlannerPtr);
+  if (native_planner && ivPlanAnytimeServer)
+  {
+    native_planner->setSolutionCallback(
+        boost::bind(&FootstepPlanner::intermediateSolutionCallback, this,
+                    _1, _2, _3));
+    native_planner->setStopCondition(
+        boost::bind(&FootstepPlanner::planningPreempted, this));
+  }
+  else if (native_planner)
+  {
+    native_planner->setSolutionCallback(
+        NativeARAPlannerBase::SolutionCallback());
+    native_planner->setStopCondition(NativeARAPlannerBase::StopCondition());
+  }
+
   ROS_INFO("Start planning (max time: %f, initial eps: %f (%f))\n",
            ivMaxSearchTime, ivInitialEpsilon,
            ivPlannerPtr->get_initial_eps());
   int path_cost;
   ros::WallTime startTime = ros::WallTime::now();
+  ivPlanningStartTime = startTime;
   try
   {
     ret = ivPlannerPtr->replan(ivMaxSearchTime, &solution_state_ids,
@@ -504,7 +629,9 @@ FootstepPlanner::plan(bool force_new_plan)
   }
 
   if (force_new_plan
-      || ivPlannerType == "RSTARPlanner" || ivPlannerType == "ARAPlanner" )
+      || ivPlannerType == "RSTARPlanner" || ivPlannerType == "ARAPlanner"
+      || ivPlannerType == "NativeARAPlanner"
+      || ivPlannerType == "NativeRStarPlanner")
   {
     reset();
   }
@@ -549,6 +676,7 @@ bool
 FootstepPlanner::planService(humanoid_nav_msgs::PlanFootsteps::Request &req,
                              humanoid_nav_msgs::PlanFootsteps::Response &resp)
 {
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
   bool result = plan(req.start.x, req.start.y, req.start.theta,
                      req.goal.x, req.goal.y, req.goal.theta);
 
@@ -570,6 +698,7 @@ bool
 FootstepPlanner::planFeetService(humanoid_nav_msgs::PlanFootstepsBetweenFeet::Request &req,
                              humanoid_nav_msgs::PlanFootstepsBetweenFeet::Response &resp)
 {
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
   // TODO check direction and change of states, force planning from scratch if does not fit
   setStart(State(req.start_left.pose.x, req.start_left.pose.y, req.start_left.pose.theta, LEFT),
            State(req.start_right.pose.x, req.start_right.pose.y, req.start_right.pose.theta, RIGHT));
@@ -591,6 +720,67 @@ FootstepPlanner::planFeetService(humanoid_nav_msgs::PlanFootstepsBetweenFeet::Re
   return true;
 }
 
+void
+FootstepPlanner::planAnytimeAction(
+    PlanFootstepsAnytimeServer* server,
+    const PlanFootstepsAnytimeGoalConstPtr& goal)
+{
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
+
+  ivPlanAnytimeServer = server;
+  bool result = plan(goal->start.x, goal->start.y, goal->start.theta,
+                     goal->goal.x, goal->goal.y, goal->goal.theta);
+  ivPlanAnytimeServer = NULL;
+
+  PlanFootstepsAnytimeResult action_result;
+  action_result.costs = getPathCosts();
+  action_result.footsteps.reserve(getPathSize());
+  action_result.final_eps = ivPlannerPtr->get_final_epsilon();
+  action_result.expanded_states =
+      ivPlannerEnvironmentPtr->getNumExpandedStates();
+  extractFootstepsSrv(action_result.footsteps);
+  action_result.result = result;
+
+  if (server->isPreemptRequested())
+    server->setPreempted(action_result);
+  else if (result)
+    server->setSucceeded(action_result);
+  else
+    server->setAborted(action_result);
+}
+
+
+void
+FootstepPlanner::intermediateSolutionCallback(
+    const std::vector<int>& state_ids, int cost, double eps)
+{
+  if (!ivPlanAnytimeServer || !extractPath(state_ids))
+    return;
+  ivPathCost = double(cost) / FootstepPlannerEnvironment::cvMmScale;
+
+  PlanFootstepsAnytimeFeedback feedback;
+  feedback.costs = ivPathCost;
+  feedback.eps = eps;
+  feedback.planning_time =
+      (ros::WallTime::now() - ivPlanningStartTime).toSec();
+  feedback.expanded_states = ivPlannerPtr->get_n_expands();
+  feedback.footsteps.reserve(getPathSize());
+  extractFootstepsSrv(feedback.footsteps);
+
+  ROS_INFO("Intermediate solution with eps %f, cost %f after %f s", eps,
+           ivPathCost, feedback.planning_time);
+  ivPlanAnytimeServer->publishFeedback(feedback);
+}
+
+
+bool
+FootstepPlanner::planningPreempted()
+{
+  return ivPlanAnytimeServer &&
+         (ivPlanAnytimeServer->isPreemptRequested() || !ros::ok());
+}
+
+
 void
 FootstepPlanner::extractFootstepsSrv(std::vector<humanoid_nav_msgs::StepTarget> & footsteps) const{
   humanoid_nav_msgs::StepTarget foot;
@@ -622,6 +812,7 @@ void
 FootstepPlanner::goalPoseCallback(
     const geometry_msgs::PoseStampedConstPtr& goal_pose)
 {
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
   // update the goal states in the environment
   if (setGoal(goal_pose))
   {
@@ -638,6 +829,7 @@ void
 FootstepPlanner::startPoseCallback(
     const geometry_msgs::PoseWithCovarianceStampedConstPtr& start_pose)
 {
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
   if (setStart(start_pose->pose.pose.position.x,
                start_pose->pose.pose.position.y,
                tf::getYaw(start_pose->pose.pose.orientation)))
@@ -655,7 +847,11 @@ void
 FootstepPlanner::mapCallback(
     const nav_msgs::OccupancyGridConstPtr& occupancy_map)
 {
-  GridMap2DPtr map(new GridMap2D(occupancy_map));
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
+  // the new map records its changes to the current one, so that the
+  // heuristic only needs to be updated around them (the current map is
+  // read under the lock, as it may be patched in place)
+  GridMap2DConstPtr map = GridMap2DCache::get(occupancy_map, ivMapPtr);
 
   // new map: update the map information
   if (updateMap(map))
@@ -667,6 +863,30 @@ FootstepPlanner::mapCallback(
 }
 
 
+void
+FootstepPlanner::mapUpdateCallback(
+    const map_msgs::OccupancyGridUpdateConstPtr& map_update)
+{
+  boost::mutex::scoped_lock lock(ivPlanningMutex);
+  if (!ivMapPtr)
+  {
+    ROS_WARN("Map update received before the map, ignoring it.");
+    return;
+  }
+
+  // copy-on-write: a shared map (e.g. from GridMap2DCache) is copied once,
+  // the own copy is then patched in place (the distance map is repaired
+  // incrementally, the heuristic follows the changes)
+  if (ivPatchedMapPtr != ivMapPtr)
+    ivPatchedMapPtr.reset(new GridMap2D(*ivMapPtr));
+  if (!ivPatchedMapPtr->applyUpdate(map_update))
+    return;
+
+  if (updateMap(ivPatchedMapPtr))
+    plan(false);
+}
+
+
 bool
 FootstepPlanner::setGoal(const geometry_msgs::PoseStampedConstPtr goal_pose)
 {
@@ -784,13 +1004,25 @@ FootstepPlanner::setStart(float x, float y, float theta)
 
 
 bool
-FootstepPlanner::updateMap(const GridMap2DPtr map)
+FootstepPlanner::updateMap(const GridMap2DConstPtr map)
 {
   // store old map pointer locally
-  GridMap2DPtr old_map = ivMapPtr;
+  GridMap2DConstPtr old_map = ivMapPtr;
+  // the own copy is outdated by another map
+  if (ivPatchedMapPtr != map)
+    ivPatchedMapPtr.reset();
   // store new map
   ivMapPtr.reset();
   ivMapPtr = map;
+  // a (shared) map of another depth is converted in an own copy; its
+  // successors (see GridMap2DCache::get()) keep the depth
+  if (map->getDistanceMapDepth() != ivDistanceMapDepth)
+  {
+    ivPatchedMapPtr.reset(new GridMap2D(*map));
+    ivPatchedMapPtr->setDistanceMapDepth(ivDistanceMapDepth,
+                                         ivDistanceMapMaxDistance);
+    ivMapPtr = ivPatchedMapPtr;
+  }
 
   // check if a previous map and a path existed
   if (old_map && (bool)ivPath.size())
@@ -800,13 +1032,13 @@ FootstepPlanner::updateMap(const GridMap2DPtr map)
   }
 
   // ..otherwise the environment's map can simply be updated
-  ivPlannerEnvironmentPtr->updateMap(map);
+  ivPlannerEnvironmentPtr->updateMap(ivMapPtr);
   return false;
 }
 
 
 void
-FootstepPlanner::updateEnvironment(const GridMap2DPtr old_map)
+FootstepPlanner::updateEnvironment(const GridMap2DConstPtr old_map)
 {
   ROS_INFO("Reseting the planning environment.");
   // reset environment
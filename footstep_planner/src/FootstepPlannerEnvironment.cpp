@@ -20,6 +20,12 @@
 
 #include <footstep_planner/FootstepPlannerEnvironment.h>
 
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/uniform_real.hpp>
+
+#include <algorithm>
+#include <map>
+
 
 namespace footstep_planner
 {
@@ -57,6 +63,8 @@ FootstepPlannerEnvironment::FootstepPlannerEnvironment(
   ivMaxStepWidth(double(disc_val(params.max_step_width, params.cell_size))),
   ivNumRandomNodes(params.num_random_nodes),
   ivRandomNodeDist(params.random_node_distance / ivCellSize),
+  ivRandomSeed(params.random_seed),
+  ivRandomGenerator(params.random_seed),
   ivHeuristicScale(params.heuristic_scale),
   ivHeuristicExpired(true),
   ivNumExpandedStates(0)
@@ -80,6 +88,13 @@ FootstepPlannerEnvironment::FootstepPlannerEnvironment(
         pointWithinPolygon(i, j, params.step_range);
     }
   }
+
+  ivSuccessorPrimitives.compile(ivFootstepSet, false, ivNumAngleBins,
+                                ivHashTableSize, ivCellSize, cvMmScale,
+                                ivStepCost);
+  ivPredecessorPrimitives.compile(ivFootstepSet, true, ivNumAngleBins,
+                                  ivHashTableSize, ivCellSize, cvMmScale,
+                                  ivStepCost);
 }
 
 
@@ -279,7 +294,7 @@ FootstepPlannerEnvironment::occupied(const PlanningState& s)
   double x = cell_2_state(s.getX(), ivCellSize);
   double y = cell_2_state(s.getY(), ivCellSize);
   // collision check for the planning state
-  if (ivMapPtr->isOccupiedAt(x,y))
+  if (ivMapView.isOccupiedAt(x,y))
     return true;
   double theta = angle_cell_2_state(s.getTheta(), ivNumAngleBins);
   double theta_cos = cos(theta);
@@ -294,7 +309,7 @@ FootstepPlannerEnvironment::occupied(const PlanningState& s)
 
   // collision check for the foot center
   return collision_check(x, y, theta, ivFootsizeX, ivFootsizeY,
-                         ivCollisionCheckAccuracy, *ivMapPtr);
+                         ivCollisionCheckAccuracy, ivMapView);
 }
 
 
@@ -316,10 +331,9 @@ FootstepPlannerEnvironment::getState(unsigned int id, State* s)
 
 
 void
-FootstepPlannerEnvironment::updateMap(gridmap_2d::GridMap2DPtr map)
+FootstepPlannerEnvironment::updateMap(gridmap_2d::GridMap2DConstPtr map)
 {
-  ivMapPtr.reset();
-  ivMapPtr = map;
+  setMap(map);
 
   if (ivHeuristicConstPtr->getHeuristicType() == Heuristic::PATH_COST)
   {
@@ -333,6 +347,26 @@ FootstepPlannerEnvironment::updateMap(gridmap_2d::GridMap2DPtr map)
 }
 
 
+void
+FootstepPlannerEnvironment::setMap(gridmap_2d::GridMap2DConstPtr map)
+{
+  ivMapPtr.reset();
+  ivMapPtr = map;
+  ivMapView = gridmap_2d::GridMap2DView(*ivMapPtr);
+
+  // cover all planning cells within the map with the expanded states' bitmap
+  const nav_msgs::MapMetaData& info = ivMapPtr->getInfo();
+  double min_x = info.origin.position.x;
+  double min_y = info.origin.position.y;
+  double max_x = min_x + info.width * info.resolution;
+  double max_y = min_y + info.height * info.resolution;
+  ivExpandedStates.resize(state_2_cell(min_x, ivCellSize),
+                          state_2_cell(min_y, ivCellSize),
+                          state_2_cell(max_x, ivCellSize),
+                          state_2_cell(max_y, ivCellSize));
+}
+
+
 void
 FootstepPlannerEnvironment::updateHeuristicValues()
 {
@@ -396,6 +430,8 @@ FootstepPlannerEnvironment::reset()
   ivExpandedStates.clear();
   ivNumExpandedStates = 0;
   ivRandomStates.clear();
+  // same random states for the same planning task
+  ivRandomGenerator.seed(ivRandomSeed);
 
   ivIdPlanningGoal = -1;
 
@@ -408,6 +444,57 @@ FootstepPlannerEnvironment::reset()
 }
 
 
+void
+FootstepPlannerEnvironment::resetTo(const FootstepPlannerEnvironment& other)
+{
+  reset();
+  // a map patched in place keeps its pointer (and size), only the view of it
+  // needs to be refreshed
+  if (ivMapPtr != other.ivMapPtr)
+    setMap(other.ivMapPtr);
+  else
+    ivMapView = other.ivMapView;
+
+  // same discrete start and goal states as 'other' (no conversion from the
+  // continuous poses); the state area of GetSuccs() / GetPreds() is not set
+  // up, only GetSuccsTo() is used on such an environment
+  ivIdStartFootLeft = importState(other, other.ivIdStartFootLeft);
+  ivIdStartFootRight = importState(other, other.ivIdStartFootRight);
+  ivIdGoalFootLeft = importState(other, other.ivIdGoalFootLeft);
+  ivIdGoalFootRight = importState(other, other.ivIdGoalFootRight);
+
+  ivHeuristicExpired = false;
+}
+
+
+int
+FootstepPlannerEnvironment::importState(const FootstepPlannerEnvironment& other,
+                                        int id)
+{
+  assert(id >= 0 && (unsigned int) id < other.ivStateId2State.size());
+
+  return createHashEntryIfNotExists(*other.ivStateId2State[id])->getId();
+}
+
+
+void
+FootstepPlannerEnvironment::mergeExpandedStates(
+    FootstepPlannerEnvironment& other)
+{
+  exp_states_2d_iter_t cell_iter;
+  for (cell_iter = other.ivExpandedStates.begin();
+       cell_iter != other.ivExpandedStates.end();
+       ++cell_iter)
+  {
+    ivExpandedStates.insert(cell_iter->first, cell_iter->second);
+  }
+  ivNumExpandedStates += other.ivNumExpandedStates;
+
+  other.ivExpandedStates.clear();
+  other.ivNumExpandedStates = 0;
+}
+
+
 bool
 FootstepPlannerEnvironment::closeToStart(const PlanningState& from)
 {
@@ -532,6 +619,107 @@ FootstepPlannerEnvironment::reachable(const PlanningState& from,
 }
 
 
+int
+FootstepPlannerEnvironment::repairPath(const State& support_foot,
+                                       const std::vector<State>& path,
+                                       size_t first_idx, int max_steps,
+                                       std::vector<State>* repair)
+{
+  repair->clear();
+  if (first_idx >= path.size() || max_steps < 1)
+    return -1;
+
+  // the path states which can be reconnected to
+  size_t last_idx = std::min(path.size() - 1, first_idx + max_steps);
+  std::vector<PlanningState> targets;
+  targets.reserve(last_idx - first_idx + 1);
+  for (size_t i = first_idx; i <= last_idx; ++i)
+  {
+    targets.push_back(PlanningState(path[i], ivCellSize, ivNumAngleBins,
+                                    ivHashTableSize));
+  }
+
+  // breadth-first search tree: each state with the index of its
+  // predecessor; duplicates are detected via the hash tag
+  std::vector<std::pair<PlanningState, int> > nodes;
+  std::multimap<unsigned int, int> visited;
+  nodes.push_back(std::make_pair(
+    PlanningState(support_foot, ivCellSize, ivNumAngleBins, ivHashTableSize),
+    -1));
+  visited.insert(std::make_pair(nodes.front().first.getHashTag(), 0));
+
+  // a sequence of 'depth' footsteps plus the reconnecting step
+  size_t depth_begin = 0;
+  for (int depth = 0; depth < max_steps; ++depth)
+  {
+    size_t depth_end = nodes.size();
+
+    // reconnect as far as possible along the path
+    int best_node = -1;
+    int best_target = -1;
+    for (size_t n = depth_begin; n < depth_end; ++n)
+    {
+      const PlanningState& s = nodes[n].first;
+      for (int t = targets.size() - 1; t > best_target; --t)
+      {
+        if (targets[t].getLeg() != s.getLeg() && reachable(s, targets[t]))
+        {
+          best_node = n;
+          best_target = t;
+          break;
+        }
+      }
+    }
+    if (best_node >= 0)
+    {
+      for (int n = best_node; n > 0; n = nodes[n].second)
+        repair->push_back(nodes[n].first.getState(ivCellSize, ivNumAngleBins));
+      std::reverse(repair->begin(), repair->end());
+      return first_idx + best_target;
+    }
+    if (depth == max_steps - 1)
+      break;
+
+    for (size_t n = depth_begin; n < depth_end; ++n)
+    {
+      const PlanningState current = nodes[n].first;
+      std::vector<Footstep>::const_iterator footstep_set_iter;
+      for (footstep_set_iter = ivFootstepSet.begin();
+           footstep_set_iter != ivFootstepSet.end();
+           ++footstep_set_iter)
+      {
+        PlanningState successor =
+          footstep_set_iter->performMeOnThisState(current);
+        if (occupied(successor))
+          continue;
+
+        bool known = false;
+        std::pair<std::multimap<unsigned int, int>::const_iterator,
+                  std::multimap<unsigned int, int>::const_iterator> range =
+          visited.equal_range(successor.getHashTag());
+        for (; range.first != range.second; ++range.first)
+        {
+          if (nodes[range.first->second].first == successor)
+          {
+            known = true;
+            break;
+          }
+        }
+        if (known)
+          continue;
+
+        visited.insert(std::make_pair(successor.getHashTag(),
+                                      (int)nodes.size()));
+        nodes.push_back(std::make_pair(successor, (int)n));
+      }
+    }
+    depth_begin = depth_end;
+  }
+
+  return -1;
+}
+
+
 void
 FootstepPlannerEnvironment::getPredsOfGridCells(
     const std::vector<State>& changed_states,
@@ -679,7 +867,7 @@ FootstepPlannerEnvironment::GetPreds(int TargetStateID,
     }
   }
 
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
+  ivExpandedStates.insert(current->getX(), current->getY());
   ++ivNumExpandedStates;
 
   if (closeToStart(*current))
@@ -697,24 +885,27 @@ FootstepPlannerEnvironment::GetPreds(int TargetStateID,
     return;
   }
 
-  PredIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
+  PredIDV->reserve(ivPredecessorPrimitives.size());
+  CostV->reserve(ivPredecessorPrimitives.size());
+  const Leg pred_leg = current->getLeg() == LEFT ? RIGHT : LEFT;
+  const FootstepPrimitives::Primitive* primitive =
+      ivPredecessorPrimitives.begin(current->getLeg(), current->getTheta());
+  const FootstepPrimitives::Primitive* primitives_end =
+      ivPredecessorPrimitives.end(current->getLeg(), current->getTheta());
+  for(; primitive != primitives_end; ++primitive)
   {
-    const PlanningState predecessor =
-        footstep_set_iter->reverseMeOnThisState(*current);
+    const PlanningState predecessor(current->getX() + primitive->dx,
+                                    current->getY() + primitive->dy,
+                                    primitive->theta, pred_leg,
+                                    ivHashTableSize);
     if (occupied(predecessor))
       continue;
 
     const PlanningState* predecessor_hash = createHashEntryIfNotExists(
         predecessor);
 
-    int cost = stepCost(*current, *predecessor_hash);
     PredIDV->push_back(predecessor_hash->getId());
-    CostV->push_back(cost);
+    CostV->push_back(primitive->cost);
   }
 }
 
@@ -777,7 +968,7 @@ FootstepPlannerEnvironment::GetSuccs(int SourceStateID,
     }
   }
 
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
+  ivExpandedStates.insert(current->getX(), current->getY());
   ++ivNumExpandedStates;
 
   if (closeToGoal(*current))
@@ -796,24 +987,27 @@ FootstepPlannerEnvironment::GetSuccs(int SourceStateID,
     return;
   }
 
-  SuccIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
+  SuccIDV->reserve(ivSuccessorPrimitives.size());
+  CostV->reserve(ivSuccessorPrimitives.size());
+  const Leg succ_leg = current->getLeg() == RIGHT ? LEFT : RIGHT;
+  const FootstepPrimitives::Primitive* primitive =
+      ivSuccessorPrimitives.begin(current->getLeg(), current->getTheta());
+  const FootstepPrimitives::Primitive* primitives_end =
+      ivSuccessorPrimitives.end(current->getLeg(), current->getTheta());
+  for(; primitive != primitives_end; ++primitive)
   {
-    PlanningState successor =
-        footstep_set_iter->performMeOnThisState(*current);
+    const PlanningState successor(current->getX() + primitive->dx,
+                                  current->getY() + primitive->dy,
+                                  primitive->theta, succ_leg,
+                                  ivHashTableSize);
     if (occupied(successor))
       continue;
 
     const PlanningState* successor_hash_entry =
         createHashEntryIfNotExists(successor);
 
-    int cost = stepCost(*current, *successor_hash_entry);
     SuccIDV->push_back(successor_hash_entry->getId());
-    CostV->push_back(cost);
+    CostV->push_back(primitive->cost);
   }
 }
 
@@ -836,7 +1030,7 @@ FootstepPlannerEnvironment::GetSuccsTo(int SourceStateID, int goalStateId,
   }
 
   const PlanningState* current = ivStateId2State[SourceStateID];
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
+  ivExpandedStates.insert(current->getX(), current->getY());
   ++ivNumExpandedStates;
 
   //ROS_INFO("GetSuccsTo %d -> %d: %f", SourceStateID, goalStateId, euclidean_distance(current->getX(), current->getY(), ivStateId2State[goalStateId]->getX(), ivStateId2State[goalStateId]->getY()));
@@ -879,23 +1073,26 @@ FootstepPlannerEnvironment::GetSuccsTo(int SourceStateID, int goalStateId,
   }
 
 
-  SuccIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
+  SuccIDV->reserve(ivSuccessorPrimitives.size());
+  CostV->reserve(ivSuccessorPrimitives.size());
+  const Leg succ_leg = current->getLeg() == RIGHT ? LEFT : RIGHT;
+  const FootstepPrimitives::Primitive* primitive =
+      ivSuccessorPrimitives.begin(current->getLeg(), current->getTheta());
+  const FootstepPrimitives::Primitive* primitives_end =
+      ivSuccessorPrimitives.end(current->getLeg(), current->getTheta());
+  for(; primitive != primitives_end; ++primitive)
   {
-    PlanningState successor =
-        footstep_set_iter->performMeOnThisState(*current);
+    const PlanningState successor(current->getX() + primitive->dx,
+                                  current->getY() + primitive->dy,
+                                  primitive->theta, succ_leg,
+                                  ivHashTableSize);
     if (occupied(successor))
       continue;
 
     const PlanningState* successor_hash = createHashEntryIfNotExists(successor);
 
-    int cost = stepCost(*current, *successor_hash);
     SuccIDV->push_back(successor_hash->getId());
-    CostV->push_back(cost);
+    CostV->push_back(primitive->cost);
   }
 }
 
@@ -1007,13 +1204,16 @@ void FootstepPlannerEnvironment::GetRandomNeighs(const PlanningState* currentSta
     ivRandomStates.push_back(goal_right->getId());
   }
 
+  boost::uniform_real<double> random_dir(0.0, TWO_PI);
+  boost::uniform_int<int> random_leg(RIGHT, LEFT);
+
   //iterate through random actions
   int nAttempts = 0;
   for (int i = 0; i < nNumofNeighs && nAttempts < 5*nNumofNeighs; ++i, ++nAttempts)
   {
 
     // pick goal in random direction
-    float fDir = (float)(TWO_PI*(((double)rand())/RAND_MAX));
+    float fDir = (float)random_dir(ivRandomGenerator);
 
     int dX = (int)(nDist_c*cos(fDir));
     int dY = (int)(nDist_c*sin(fDir));
@@ -1034,7 +1234,7 @@ void FootstepPlannerEnvironment::GetRandomNeighs(const PlanningState* currentSta
     int newTheta = angle_state_2_cell(fDir, ivNumAngleBins);
 
     // random left/right
-    Leg newLeg = Leg(rand() % 2);
+    Leg newLeg = Leg(random_leg(ivRandomGenerator));
 
     PlanningState randomState(newX, newY, newTheta, newLeg, ivHashTableSize);
 
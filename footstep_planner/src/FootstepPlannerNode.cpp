@@ -22,21 +22,44 @@
 
 namespace footstep_planner
 {
-FootstepPlannerNode::FootstepPlannerNode()
+FootstepPlannerNode::FootstepPlannerNode(ros::NodeHandle nh,
+                                         ros::NodeHandle nh_private)
+: ivFootstepPlanner(nh_private)
 {
-  ros::NodeHandle nh;
-
   // provide callbacks to interact with the footstep planner:
   ivGridMapSub = nh.subscribe<nav_msgs::OccupancyGrid>("map", 1, &FootstepPlanner::mapCallback, &ivFootstepPlanner);
+  ivGridMapUpdateSub = nh.subscribe<map_msgs::OccupancyGridUpdate>("map_updates", 10, &FootstepPlanner::mapUpdateCallback, &ivFootstepPlanner);
   ivGoalPoseSub = nh.subscribe<geometry_msgs::PoseStamped>("goal", 1, &FootstepPlanner::goalPoseCallback, &ivFootstepPlanner);
   ivStartPoseSub = nh.subscribe<geometry_msgs::PoseWithCovarianceStamped>("initialpose", 1, &FootstepPlanner::startPoseCallback, &ivFootstepPlanner);
 
   // service:
   ivFootstepPlanService = nh.advertiseService("plan_footsteps", &FootstepPlanner::planService, &ivFootstepPlanner);
   ivFootstepPlanFeetService = nh.advertiseService("plan_footsteps_feet", &FootstepPlanner::planFeetService, &ivFootstepPlanner);
+
+  // action:
+  ros::NodeHandle action_nh(nh);
+  action_nh.setCallbackQueue(&ivActionQueue);
+  ivPlanAnytimeServer.reset(new PlanFootstepsAnytimeServer(
+      action_nh, "plan_footsteps_anytime",
+      boost::bind(&FootstepPlannerNode::planAnytimeCallback, this, _1),
+      false));
+  ivActionSpinner.reset(new ros::AsyncSpinner(1, &ivActionQueue));
+  ivActionSpinner->start();
+  ivPlanAnytimeServer->start();
 }
 
 
 FootstepPlannerNode::~FootstepPlannerNode()
-{}
+{
+  ivPlanAnytimeServer->shutdown();
+  ivActionSpinner->stop();
+}
+
+
+void
+FootstepPlannerNode::planAnytimeCallback(
+    const PlanFootstepsAnytimeGoalConstPtr& goal)
+{
+  ivFootstepPlanner.planAnytimeAction(ivPlanAnytimeServer.get(), goal);
+}
 }
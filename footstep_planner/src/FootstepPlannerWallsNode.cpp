@@ -0,0 +1,150 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/FootstepPlannerWallsNode.h>
+
+using gridmap_2d::GridMap2D;
+using gridmap_2d::GridMap2DCache;
+using gridmap_2d::GridMap2DConstPtr;
+using gridmap_2d::GridMap2DPtr;
+
+
+namespace footstep_planner
+{
+FootstepPlannerWallsNode::FootstepPlannerWallsNode(ros::NodeHandle nh,
+                                                   ros::NodeHandle nh_private)
+: ivNh(nh),
+  ivFootstepPlanner(nh_private)
+{
+  // params:
+  nh_private.param("footstep_wall_dist", ivFootstepWallDist, 0.15);
+
+  // provide callbacks to interact with the footstep planner:
+  ivGridMapSub = ivNh.subscribe<nav_msgs::OccupancyGrid>("map", 1, &FootstepPlannerWallsNode::mapCallback, this);
+  ivGridMapUpdateSub = ivNh.subscribe<map_msgs::OccupancyGridUpdate>("map_updates", 10, &FootstepPlannerWallsNode::mapUpdateCallback, this);
+  ivGoalPoseSub = ivNh.subscribe<geometry_msgs::PoseStamped>("goal", 1, &FootstepPlanner::goalPoseCallback, &ivFootstepPlanner);
+  ivStartPoseSub = ivNh.subscribe<geometry_msgs::PoseWithCovarianceStamped>("initialpose", 1, &FootstepPlanner::startPoseCallback, &ivFootstepPlanner);
+
+  // service:
+  ivFootstepPlanService = ivNh.advertiseService("plan_footsteps", &FootstepPlanner::planService, &ivFootstepPlanner);
+}
+
+
+FootstepPlannerWallsNode::~FootstepPlannerWallsNode()
+{}
+
+
+void
+FootstepPlannerWallsNode::mapCallback(
+    const nav_msgs::OccupancyGridConstPtr& occupancyMap)
+{
+  ROS_INFO("Obstacle map received, now waiting for wall map.");
+  ivGridMap = GridMap2DCache::get(occupancyMap, ivGridMap);
+  ivPatchedGridMap.reset();
+  // don't set wall => wait for wall map!
+  //ivFootstepPlanner.setMap(ivGridMap);
+
+  // now subscribe to walls, so that they arrive in order:
+  ivWallMapSub = ivNh.subscribe<nav_msgs::OccupancyGrid>(
+    "map_walls", 1, &FootstepPlannerWallsNode::wallMapCallback, this);
+}
+
+
+void
+FootstepPlannerWallsNode::wallMapCallback(
+    const nav_msgs::OccupancyGridConstPtr& occupancyMap)
+{
+  ROS_INFO("Wall / Obstacle map received");
+  assert(ivGridMap);
+  // the distance map of the walls is shared, the combined map is a copy
+  ivWallMap = GridMap2DCache::get(occupancyMap, ivWallMap);
+
+  // the inflated wall map is shared, combine into a new cv::Mat
+  cv::Mat binaryMap;
+  bitwise_and(ivWallMap->inflatedBinaryMap(ivFootstepWallDist),
+              ivGridMap->binaryMap(), binaryMap);
+
+  // the combined map is an own copy: if the geometry did not change, it is
+  // updated in place and its journal continued, so that the planner's
+  // heuristic follows the changes
+  const nav_msgs::MapMetaData& info = ivWallMap->getInfo();
+  if (!ivCombinedMap
+      || ivCombinedMap->getInfo().width != info.width
+      || ivCombinedMap->getInfo().height != info.height
+      || ivCombinedMap->getInfo().resolution != info.resolution
+      || ivCombinedMap->getInfo().origin.position.x != info.origin.position.x
+      || ivCombinedMap->getInfo().origin.position.y != info.origin.position.y)
+    ivCombinedMap.reset(new GridMap2D(*ivWallMap));
+  ivCombinedMap->setMap(binaryMap);
+
+  ivFootstepPlanner.updateMap(ivCombinedMap);
+}
+
+
+void
+FootstepPlannerWallsNode::mapUpdateCallback(
+    const map_msgs::OccupancyGridUpdateConstPtr& mapUpdate)
+{
+  if (!ivGridMap)
+  {
+    ROS_WARN("Map update received before the obstacle map, ignoring it.");
+    return;
+  }
+
+  // copy-on-write: the obstacle map from GridMap2DCache is copied once,
+  // the own copy is then patched in place
+  if (ivPatchedGridMap != ivGridMap)
+    ivPatchedGridMap.reset(new GridMap2D(*ivGridMap));
+  if (!ivPatchedGridMap->applyUpdate(mapUpdate))
+    return;
+  ivGridMap = ivPatchedGridMap;
+
+  // no walls yet => the combined map is created with the wall map
+  if (!ivCombinedMap
+      || ivCombinedMap->getInfo().width != ivGridMap->getInfo().width
+      || ivCombinedMap->getInfo().height != ivGridMap->getInfo().height)
+    return;
+
+  // recombine the patched cells in place (rows of the update are columns
+  // of the maps), the planner is notified below
+  const cv::Mat wallMap = ivWallMap->inflatedBinaryMap(ivFootstepWallDist);
+  std::vector<cv::Point> changedCells;
+  for (unsigned int my = mapUpdate->y; my < mapUpdate->y + mapUpdate->height; ++my)
+  {
+    for (unsigned int mx = mapUpdate->x; mx < mapUpdate->x + mapUpdate->width; ++mx)
+    {
+      const uchar value = std::min(wallMap.at<uchar>(mx, my),
+                                   ivGridMap->binaryMapAtCell(mx, my));
+      uchar& cell = ivCombinedMap->binaryMapAtCell(mx, my);
+      if (cell != value)
+      {
+        cell = value;
+        changedCells.push_back(cv::Point(mx, my));
+      }
+    }
+  }
+  if (changedCells.empty())
+    return;
+
+  ivCombinedMap->updateDistanceMap(changedCells);
+
+  ivFootstepPlanner.updateMap(ivCombinedMap);
+}
+}
@@ -0,0 +1,78 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/FootstepPrimitives.h>
+
+
+namespace footstep_planner
+{
+FootstepPrimitives::FootstepPrimitives()
+: ivNumAngleBins(0),
+  ivNumSteps(0)
+{}
+
+
+FootstepPrimitives::~FootstepPrimitives()
+{}
+
+
+void
+FootstepPrimitives::compile(const std::vector<Footstep>& footstep_set,
+                            bool reverse, int num_angle_bins,
+                            int max_hash_size, double cell_size,
+                            int mm_scale, int step_cost)
+{
+  ivNumAngleBins = num_angle_bins;
+  ivNumSteps = footstep_set.size();
+  // one row per leg (RIGHT, LEFT) and orientation
+  ivPrimitives.resize(2 * num_angle_bins * ivNumSteps);
+
+  const Leg legs[2] = { RIGHT, LEFT };
+  for (int l = 0; l < 2; ++l)
+  {
+    for (int theta = 0; theta < num_angle_bins; ++theta)
+    {
+      // the steps are translations, so performing them on the origin
+      // yields the relative step
+      const PlanningState origin(0, 0, theta, legs[l], max_hash_size);
+      Primitive* primitive = &ivPrimitives[
+          (legs[l] * num_angle_bins + theta) * ivNumSteps];
+
+      std::vector<Footstep>::const_iterator footstep_set_iter;
+      for (footstep_set_iter = footstep_set.begin();
+           footstep_set_iter != footstep_set.end();
+           ++footstep_set_iter, ++primitive)
+      {
+        const PlanningState step = reverse ?
+            footstep_set_iter->reverseMeOnThisState(origin) :
+            footstep_set_iter->performMeOnThisState(origin);
+        primitive->dx = step.getX();
+        primitive->dy = step.getY();
+        primitive->theta = step.getTheta();
+
+        // same as FootstepPlannerEnvironment::stepCost()
+        double dist = euclidean_distance(0, 0, step.getX(), step.getY()) *
+            cell_size;
+        primitive->cost = int(mm_scale * dist) + step_cost;
+      }
+    }
+  }
+}
+}
@@ -36,7 +36,8 @@ PathCostHeuristic::PathCostHeuristic(double cell_size,
   ivMaxStepWidth(max_step_width),
   ivInflationRadius(inflation_radius),
   ivGoalX(-1),
-  ivGoalY(-1)
+  ivGoalY(-1),
+  ivMapRevision(0)
 {}
 
 
@@ -60,14 +61,14 @@ const
   unsigned int from_x;
   unsigned int from_y;
   // could be removed after more testing (then use ...noBounds... again)
-  ivMapPtr->worldToMapNoBounds(cell_2_state(current.getX(), ivCellSize),
+  ivMapView.worldToMapNoBounds(cell_2_state(current.getX(), ivCellSize),
                                cell_2_state(current.getY(), ivCellSize),
                                from_x, from_y);
 
   unsigned int to_x;
   unsigned int to_y;
   // could be removed after more testing (then use ...noBounds... again)
-  ivMapPtr->worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
+  ivMapView.worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
                                cell_2_state(to.getY(), ivCellSize),
                                to_x, to_y);
 
@@ -108,13 +109,13 @@ PathCostHeuristic::calculateDistances(const PlanningState& from,
 
   unsigned int from_x;
   unsigned int from_y;
-  ivMapPtr->worldToMapNoBounds(cell_2_state(from.getX(), ivCellSize),
+  ivMapView.worldToMapNoBounds(cell_2_state(from.getX(), ivCellSize),
                                cell_2_state(from.getY(), ivCellSize),
                                from_x, from_y);
 
   unsigned int to_x;
   unsigned int to_y;
-  ivMapPtr->worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
+  ivMapView.worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
                                cell_2_state(to.getY(), ivCellSize),
                                to_x, to_y);
 
@@ -131,35 +132,152 @@ PathCostHeuristic::calculateDistances(const PlanningState& from,
 }
 
 
+bool
+PathCostHeuristic::calculatePath2D(
+    double from_x, double from_y, double to_x, double to_y,
+    std::vector<std::pair<double, double> >* path)
+{
+  assert(ivMapPtr);
+  path->clear();
+
+  unsigned int x, y;
+  unsigned int goal_x, goal_y;
+  if (!ivMapPtr->worldToMap(from_x, from_y, x, y) ||
+      !ivMapPtr->worldToMap(to_x, to_y, goal_x, goal_y))
+  {
+    return false;
+  }
+
+  if ((int)goal_x != ivGoalX || (int)goal_y != ivGoalY)
+  {
+    ivGoalX = goal_x;
+    ivGoalY = goal_y;
+    ivGridSearchPtr->search(ivpGrid, cvObstacleThreshold,
+                            ivGoalX, ivGoalY, x, y,
+                            SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+  }
+
+  int width = ivMapPtr->getInfo().width;
+  int height = ivMapPtr->getInfo().height;
+  int cost = ivGridSearchPtr->getlowerboundoncostfromstart_inmm(x, y);
+  if (cost >= INFINITECOST)
+    return false;
+
+  double wx, wy;
+  ivMapPtr->mapToWorld(x, y, wx, wy);
+  path->push_back(std::pair<double, double>(wx, wy));
+  while (x != goal_x || y != goal_y)
+  {
+    // move to the neighbor with the lowest path costs
+    int best_cost = cost;
+    unsigned int best_x = x;
+    unsigned int best_y = y;
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+      for (int dx = -1; dx <= 1; ++dx)
+      {
+        int nx = x + dx;
+        int ny = y + dy;
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+          continue;
+        int n_cost = ivGridSearchPtr->getlowerboundoncostfromstart_inmm(nx, ny);
+        if (n_cost < best_cost)
+        {
+          best_cost = n_cost;
+          best_x = nx;
+          best_y = ny;
+        }
+      }
+    }
+    // no descent (should not happen for a reachable goal)
+    if (best_cost >= cost)
+    {
+      path->clear();
+      return false;
+    }
+
+    x = best_x;
+    y = best_y;
+    cost = best_cost;
+    ivMapPtr->mapToWorld(x, y, wx, wy);
+    path->push_back(std::pair<double, double>(wx, wy));
+  }
+
+  return true;
+}
+
+
 void
-PathCostHeuristic::updateMap(gridmap_2d::GridMap2DPtr map)
+PathCostHeuristic::updateMap(gridmap_2d::GridMap2DConstPtr map)
 {
+  // for known changes to the previous map (of the same size) only the grid
+  // around the changed regions needs to be updated
+  std::vector<cv::Rect> changed_regions;
+  bool update_changes =
+    ivpGrid && ivMapPtr &&
+    ivMapPtr->getInfo().width == map->getInfo().width &&
+    ivMapPtr->getInfo().height == map->getInfo().height &&
+    map->getChangesSince(ivMapRevision, changed_regions);
+
+  if (ivpGrid && !update_changes)
+    resetGrid();
+
   ivMapPtr.reset();
   ivMapPtr = map;
+  ivMapRevision = ivMapPtr->getRevision();
+  ivMapView = gridmap_2d::GridMap2DView(*ivMapPtr);
 
   ivGoalX = ivGoalY = -1;
 
   unsigned width = ivMapPtr->getInfo().width;
   unsigned height = ivMapPtr->getInfo().height;
 
+  // obstacles of the map inflated by the inflation radius (shared with
+  // all users of the map)
+  const cv::Mat inflated = ivMapPtr->inflatedBinaryMap(ivInflationRadius);
+
+  if (update_changes)
+  {
+    // inflated obstacles change up to the inflation radius around changes
+    const int border =
+      int(ceil(ivInflationRadius / ivMapPtr->getResolution())) + 1;
+    const cv::Rect map_cells(0, 0, width, height);
+    std::vector<cv::Rect>::const_iterator region_iter;
+    for (region_iter = changed_regions.begin();
+         region_iter != changed_regions.end();
+         ++region_iter)
+    {
+      cv::Rect region(region_iter->x - border, region_iter->y - border,
+                      region_iter->width + 2 * border,
+                      region_iter->height + 2 * border);
+      updateGrid(inflated, region & map_cells);
+    }
+    ROS_DEBUG("Heuristic grid updated in %d changed regions",
+              (int)changed_regions.size());
+    return;
+  }
+
   if (ivGridSearchPtr)
     ivGridSearchPtr->destroy();
   ivGridSearchPtr.reset(new SBPL2DGridSearch(width, height,
                                              ivMapPtr->getResolution()));
-  if (ivpGrid)
-    resetGrid();
   ivpGrid = new unsigned char* [width];
 
   for (unsigned x = 0; x < width; ++x)
     ivpGrid[x] = new unsigned char [height];
-  for (unsigned y = 0; y < height; ++y)
+  updateGrid(inflated, cv::Rect(0, 0, width, height));
+}
+
+
+void
+PathCostHeuristic::updateGrid(const cv::Mat& inflated, const cv::Rect& region)
+{
+  for (int x = region.x; x < region.x + region.width; ++x)
   {
-    for (unsigned x = 0; x < width; ++x)
+    const uchar* inflated_row = inflated.ptr<uchar>(x);
+    for (int y = region.y; y < region.y + region.height; ++y)
     {
-      float dist = ivMapPtr->distanceMapAtCell(x,y);
-      if (dist < 0.0f)
-        ROS_ERROR("Distance map at %d %d out of bounds", x, y);
-      else if (dist <= ivInflationRadius)
+      if (inflated_row[y] == gridmap_2d::GridMap2D::OCCUPIED)
         ivpGrid[x][y] = 255;
       else
         ivpGrid[x][y] = 0;
@@ -171,8 +289,9 @@ PathCostHeuristic::updateMap(gridmap_2d::GridMap2DPtr map)
 void
 PathCostHeuristic::resetGrid()
 {
-  CvSize size = ivMapPtr->size();
-  for (int x = 0; x < size.width; ++x)
+  // the grid has the size of the current map (ivpGrid[width][height])
+  unsigned width = ivMapPtr->getInfo().width;
+  for (unsigned x = 0; x < width; ++x)
   {
     if (ivpGrid[x])
     {
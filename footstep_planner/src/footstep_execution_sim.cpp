@@ -0,0 +1,265 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ros/ros.h>
+#include <actionlib/server/simple_action_server.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <humanoid_nav_msgs/ClipFootstep.h>
+#include <humanoid_nav_msgs/ExecFootstepsAction.h>
+#include <humanoid_nav_msgs/StepTargetService.h>
+#include <tf/transform_broadcaster.h>
+#include <tf/transform_datatypes.h>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
+
+
+/**
+ * @brief Stand-in for the footstep execution of a humanoid robot, used to
+ * run FootstepNavigation without a robot. Provides the footstep service,
+ * the clip footstep service and the footstep execution action (as
+ * FootstepNavigation expects them) and publishes the simulated foot poses
+ * via tf.
+ *
+ * Each footstep takes 'step_duration' seconds, after which the swing foot
+ * is placed relative to the support foot with additive Gaussian noise
+ * ('noise/x', 'noise/y', 'noise/theta'). Each performed footstep is
+ * published as 'executed_footstep' (pose of the placed foot, stamped with
+ * the start of the step) to measure the latencies of the navigation.
+ */
+class FootstepExecutionSim
+{
+public:
+  FootstepExecutionSim()
+  : ivExecServer(ivNh, "footsteps_execution",
+                 boost::bind(&FootstepExecutionSim::executeCallback, this,
+                             _1),
+                 false),
+    ivRandomGenerator(0)
+  {
+    ros::NodeHandle privateNh("~");
+    // params:
+    privateNh.param("world_frame_id", ivIdWorldFrame, std::string("map"));
+    privateNh.param("rfoot_frame_id", ivIdFootRight, std::string("/r_sole"));
+    privateNh.param("lfoot_frame_id", ivIdFootLeft, std::string("/l_sole"));
+    privateNh.param("step_duration", ivStepDuration, 0.5);
+    privateNh.param("noise/x", ivNoiseX, 0.0);
+    privateNh.param("noise/y", ivNoiseY, 0.0);
+    privateNh.param("noise/theta", ivNoiseTheta, 0.0);
+    privateNh.param("foot/separation", ivFootSeparation, 0.095);
+    double tf_rate;
+    privateNh.param("tf_rate", tf_rate, 50.0);
+    int random_seed;
+    privateNh.param("random_seed", random_seed, 0);
+    ivRandomGenerator.seed((unsigned int)random_seed);
+
+    // executable range of a footstep (for clipping)
+    privateNh.param("foot/max/step/x", ivMaxStepX, 0.07);
+    privateNh.param("foot/max/step/y", ivMaxStepY, 0.15);
+    privateNh.param("foot/max/step/theta", ivMaxStepTheta, 0.3);
+    privateNh.param("foot/max/inverse/step/x", ivMaxInvStepX, -0.03);
+    privateNh.param("foot/max/inverse/step/y", ivMaxInvStepY, 0.09);
+    privateNh.param("foot/max/inverse/step/theta", ivMaxInvStepTheta, -0.01);
+
+    double x, y, theta;
+    privateNh.param("start/x", x, 0.0);
+    privateNh.param("start/y", y, 0.0);
+    privateNh.param("start/theta", theta, 0.0);
+    placeRobot(x, y, theta);
+
+    // provide the interface of the footstep execution:
+    ivStartPoseSub = ivNh.subscribe<geometry_msgs::PoseWithCovarianceStamped>("initialpose", 1, &FootstepExecutionSim::startPoseCallback, this);
+    ivExecutedFootstepPub = privateNh.advertise<geometry_msgs::PoseStamped>("executed_footstep", 10);
+    ivFootstepService = ivNh.advertiseService("footstep_srv", &FootstepExecutionSim::footstepService, this);
+    ivClipFootstepService = ivNh.advertiseService("clip_footstep_srv", &FootstepExecutionSim::clipFootstepService, this);
+    ivTfTimer = ivNh.createTimer(ros::Duration(1.0 / tf_rate), &FootstepExecutionSim::tfCallback, this);
+
+    ivExecServer.start();
+  }
+
+  virtual ~FootstepExecutionSim(){}
+
+  /// @brief Places the feet next to each other at the robot pose (x, y, theta).
+  void placeRobot(double x, double y, double theta)
+  {
+    tf::Pose robot(tf::createQuaternionFromYaw(theta), tf::Point(x, y, 0.0));
+
+    boost::mutex::scoped_lock lock(ivFeetMutex);
+    ivFootLeft = robot * tf::Pose(tf::createIdentityQuaternion(),
+                                  tf::Point(0.0, ivFootSeparation / 2.0, 0.0));
+    ivFootRight = robot * tf::Pose(tf::createIdentityQuaternion(),
+                                   tf::Point(0.0, -ivFootSeparation / 2.0, 0.0));
+  }
+
+  void startPoseCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& startPose)
+  {
+    ROS_INFO("Placing the simulated robot at (%f %f %f)",
+             startPose->pose.pose.position.x, startPose->pose.pose.position.y,
+             tf::getYaw(startPose->pose.pose.orientation));
+    placeRobot(startPose->pose.pose.position.x,
+               startPose->pose.pose.position.y,
+               tf::getYaw(startPose->pose.pose.orientation));
+  }
+
+  void tfCallback(const ros::TimerEvent& event)
+  {
+    std::vector<tf::StampedTransform> feet;
+    ros::Time now = ros::Time::now();
+    {
+      boost::mutex::scoped_lock lock(ivFeetMutex);
+      feet.push_back(tf::StampedTransform(ivFootLeft, now, ivIdWorldFrame, ivIdFootLeft));
+      feet.push_back(tf::StampedTransform(ivFootRight, now, ivIdWorldFrame, ivIdFootRight));
+    }
+    ivTfBroadcaster.sendTransform(feet);
+  }
+
+  bool footstepService(humanoid_nav_msgs::StepTargetService::Request& req,
+                       humanoid_nav_msgs::StepTargetService::Response& resp)
+  {
+    performFootstep(req.step);
+    return true;
+  }
+
+  bool clipFootstepService(humanoid_nav_msgs::ClipFootstep::Request& req,
+                           humanoid_nav_msgs::ClipFootstep::Response& resp)
+  {
+    resp.step = req.step;
+    // the range is defined for the left foot as swing foot
+    double sign = (req.step.leg == humanoid_nav_msgs::StepTarget::right) ? -1.0 : 1.0;
+    resp.step.pose.x = std::max(ivMaxInvStepX, std::min(ivMaxStepX, req.step.pose.x));
+    resp.step.pose.y = sign * std::max(ivMaxInvStepY, std::min(ivMaxStepY, sign * req.step.pose.y));
+    resp.step.pose.theta = sign * std::max(ivMaxInvStepTheta, std::min(ivMaxStepTheta, sign * req.step.pose.theta));
+    return true;
+  }
+
+  void executeCallback(const humanoid_nav_msgs::ExecFootstepsGoalConstPtr& goal)
+  {
+    humanoid_nav_msgs::ExecFootstepsFeedback feedback;
+    std::vector<humanoid_nav_msgs::StepTarget>::const_iterator step_iter;
+    for (step_iter = goal->footsteps.begin();
+         step_iter != goal->footsteps.end();
+         ++step_iter)
+    {
+      if (ivExecServer.isPreemptRequested() || !ros::ok())
+      {
+        humanoid_nav_msgs::ExecFootstepsResult result;
+        result.executed_footsteps = feedback.executed_footsteps;
+        ivExecServer.setPreempted(result);
+        return;
+      }
+      performFootstep(*step_iter);
+      feedback.executed_footsteps.push_back(*step_iter);
+      ivExecServer.publishFeedback(feedback);
+    }
+
+    humanoid_nav_msgs::ExecFootstepsResult result;
+    result.executed_footsteps = feedback.executed_footsteps;
+    ivExecServer.setSucceeded(result);
+  }
+
+protected:
+  /**
+   * @brief Performs 'step' (relative to the support foot, 'leg' being the
+   * swing foot): waits for the step duration and places the swing foot.
+   */
+  void performFootstep(const humanoid_nav_msgs::StepTarget& step)
+  {
+    geometry_msgs::PoseStamped executed;
+    executed.header.stamp = ros::Time::now();
+    executed.header.frame_id = ivIdWorldFrame;
+
+    tf::Pose target;
+    {
+      // also guards the random generator, steps are performed from the
+      // action thread and the service callbacks
+      boost::mutex::scoped_lock lock(ivFeetMutex);
+      const tf::Pose& support =
+        (step.leg == humanoid_nav_msgs::StepTarget::left) ? ivFootRight : ivFootLeft;
+      target = support *
+        tf::Pose(tf::createQuaternionFromYaw(step.pose.theta + noise(ivNoiseTheta)),
+                 tf::Point(step.pose.x + noise(ivNoiseX),
+                           step.pose.y + noise(ivNoiseY), 0.0));
+    }
+
+    ros::Duration(ivStepDuration).sleep();
+    {
+      boost::mutex::scoped_lock lock(ivFeetMutex);
+      if (step.leg == humanoid_nav_msgs::StepTarget::left)
+        ivFootLeft = target;
+      else
+        ivFootRight = target;
+    }
+
+    tf::poseTFToMsg(target, executed.pose);
+    ivExecutedFootstepPub.publish(executed);
+  }
+
+  /// @brief Draws zero-mean Gaussian noise, ivFeetMutex must be held.
+  double noise(double stddev)
+  {
+    if (stddev <= 0.0)
+      return 0.0;
+    boost::variate_generator<boost::mt19937&, boost::normal_distribution<> >
+      gen(ivRandomGenerator, boost::normal_distribution<>(0.0, stddev));
+    return gen();
+  }
+
+  ros::NodeHandle ivNh;
+  actionlib::SimpleActionServer<humanoid_nav_msgs::ExecFootstepsAction> ivExecServer;
+  ros::Subscriber ivStartPoseSub;
+  ros::Publisher ivExecutedFootstepPub;
+  ros::ServiceServer ivFootstepService, ivClipFootstepService;
+  ros::Timer ivTfTimer;
+  tf::TransformBroadcaster ivTfBroadcaster;
+
+  /// Locks the foot poses and ivRandomGenerator (the steps are performed
+  /// outside the tf thread).
+  boost::mutex ivFeetMutex;
+  tf::Pose ivFootLeft, ivFootRight;
+
+  std::string ivIdWorldFrame, ivIdFootLeft, ivIdFootRight;
+  double ivStepDuration;
+  double ivNoiseX, ivNoiseY, ivNoiseTheta;
+  double ivFootSeparation;
+  double ivMaxStepX, ivMaxStepY, ivMaxStepTheta;
+  double ivMaxInvStepX, ivMaxInvStepY, ivMaxInvStepTheta;
+
+  boost::mt19937 ivRandomGenerator;
+};
+
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "footstep_execution_sim");
+
+  FootstepExecutionSim sim;
+
+  // footsteps block their callback for the step duration, tf is published
+  // meanwhile
+  ros::MultiThreadedSpinner spinner(2);
+  spinner.spin();
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the planner types of the FootstepPlanner (e.g. SBPL's ARAPlanner
+ * and the NativeARAPlanner) on random start / goal poses in the map
+ * received on "map" (see launch/footstep_planner_benchmark.launch). All
+ * other planning parameters are read from the node's namespace.
+ */
+
+#include <footstep_planner/FootstepPlanner.h>
+#include <gridmap_2d/GridMap2D.h>
+#include <ros/ros.h>
+#include <ros/topic.h>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+
+struct PoseQuery
+{
+  double start_x, start_y, start_theta;
+  double goal_x, goal_y, goal_theta;
+};
+
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "footstep_planner_benchmark");
+  ros::NodeHandle nh;
+  ros::NodeHandle nh_private("~");
+
+  std::string planner_types;
+  int num_queries, random_seed;
+  double clearance;
+  nh_private.param("planner_types", planner_types,
+                   std::string("ARAPlanner NativeARAPlanner"));
+  nh_private.param("num_queries", num_queries, 20);
+  nh_private.param("benchmark_seed", random_seed, 0);
+  // minimal distance of the start and goal poses to obstacles
+  nh_private.param("clearance", clearance, 0.2);
+
+  ROS_INFO("Waiting for map...");
+  nav_msgs::OccupancyGridConstPtr occupancy_map =
+    ros::topic::waitForMessage<nav_msgs::OccupancyGrid>("map", nh);
+  if (!occupancy_map)
+    return 1;
+  gridmap_2d::GridMap2DConstPtr map(new gridmap_2d::GridMap2D(occupancy_map));
+
+  // random start / goal poses with some clearance, also unreachable ones
+  std::vector<std::pair<unsigned int, unsigned int> > free_cells;
+  for (unsigned int mx = 0; mx < map->getInfo().width; ++mx)
+  {
+    for (unsigned int my = 0; my < map->getInfo().height; ++my)
+    {
+      if (map->distanceMapAtCell(mx, my) > clearance)
+        free_cells.push_back(std::make_pair(mx, my));
+    }
+  }
+  if (free_cells.empty())
+  {
+    ROS_ERROR("No cells with a clearance of %f m in the map", clearance);
+    return 1;
+  }
+
+  boost::mt19937 rng(random_seed);
+  boost::variate_generator<boost::mt19937&, boost::uniform_int<size_t> >
+    random_cell(rng, boost::uniform_int<size_t>(0, free_cells.size() - 1));
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<> >
+    random_angle(rng, boost::uniform_real<>(-M_PI, M_PI));
+  std::vector<PoseQuery> queries(num_queries);
+  for (int i = 0; i < num_queries; ++i)
+  {
+    const std::pair<unsigned int, unsigned int>& start = free_cells[random_cell()];
+    const std::pair<unsigned int, unsigned int>& goal = free_cells[random_cell()];
+    map->mapToWorld(start.first, start.second,
+                    queries[i].start_x, queries[i].start_y);
+    map->mapToWorld(goal.first, goal.second,
+                    queries[i].goal_x, queries[i].goal_y);
+    queries[i].start_theta = random_angle();
+    queries[i].goal_theta = random_angle();
+  }
+
+  ROS_INFO("Map with %d x %d cells, %d queries", map->getInfo().width,
+           map->getInfo().height, num_queries);
+
+  std::istringstream types(planner_types);
+  std::string planner_type;
+  while (types >> planner_type && ros::ok())
+  {
+    // the FootstepPlanner reads its parameters from this node's namespace
+    nh_private.setParam("planner_type", planner_type);
+    footstep_planner::FootstepPlanner planner;
+    planner.updateMap(map);
+
+    int num_solved = 0;
+    double total_time = 0.0, max_time = 0.0, total_costs = 0.0;
+    size_t total_expansions = 0;
+    for (int i = 0; i < num_queries && ros::ok(); ++i)
+    {
+      const PoseQuery& query = queries[i];
+      ros::WallTime start_time = ros::WallTime::now();
+      const bool solved = planner.plan(
+        query.start_x, query.start_y, query.start_theta,
+        query.goal_x, query.goal_y, query.goal_theta);
+      const double time = (ros::WallTime::now() - start_time).toSec();
+      total_time += time;
+      max_time = std::max(max_time, time);
+      if (solved)
+      {
+        ++num_solved;
+        total_costs += planner.getPathCosts();
+        total_expansions += planner.getNumExpandedStates();
+      }
+    }
+
+    ROS_INFO("%s: %d / %d solved, query time mean %f s, max %f s, "
+             "mean path costs %f, mean expansions %f",
+             planner_type.c_str(), num_solved, num_queries,
+             total_time / std::max(num_queries, 1), max_time,
+             total_costs / std::max(num_solved, 1),
+             double(total_expansions) / std::max(num_solved, 1));
+  }
+
+  return 0;
+}
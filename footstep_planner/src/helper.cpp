@@ -25,9 +25,9 @@ namespace footstep_planner
 bool
 collision_check(double x, double y, double theta, double height,
                 double width, int accuracy,
-                const gridmap_2d::GridMap2D& distance_map)
+                const gridmap_2d::GridMap2DView& distance_map)
 {
-  double d = distance_map.distanceMapAt(x, y);
+  double d = distance_map.distanceAt(x, y);
   if (d < 0.0) // if out of bounds => collision
     return true;
   d -= distance_map.getResolution();
@@ -80,6 +80,16 @@ collision_check(double x, double y, double theta, double height,
 }
 
 
+bool
+collision_check(double x, double y, double theta, double height,
+                double width, int accuracy,
+                const gridmap_2d::GridMap2D& distance_map)
+{
+  return collision_check(x, y, theta, height, width, accuracy,
+                         gridmap_2d::GridMap2DView(distance_map));
+}
+
+
 bool
 pointWithinPolygon(int x, int y, const std::vector<std::pair<int, int> >& edges)
 {
@@ -0,0 +1,89 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/FootstepNavigation.h>
+#include <footstep_planner/FootstepPlannerNode.h>
+#include <footstep_planner/FootstepPlannerWallsNode.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <boost/scoped_ptr.hpp>
+
+
+namespace footstep_planner
+{
+/*
+ * Nodelet versions of footstep_planner_node, footstep_navigation_node and
+ * footstep_planner_walls. Loaded into the same nodelet manager, they share
+ * the map messages and the GridMap2D (incl. its distance map) built from
+ * them (see gridmap_2d::GridMap2DCache) instead of each creating its own.
+ */
+
+/// @brief FootstepPlannerNode as nodelet.
+class FootstepPlannerNodelet : public nodelet::Nodelet
+{
+public:
+  virtual void onInit()
+  {
+    ivNodePtr.reset(new FootstepPlannerNode(getNodeHandle(),
+                                            getPrivateNodeHandle()));
+  }
+
+private:
+  boost::scoped_ptr<FootstepPlannerNode> ivNodePtr;
+};
+
+
+/// @brief FootstepNavigation as nodelet.
+class FootstepNavigationNodelet : public nodelet::Nodelet
+{
+public:
+  virtual void onInit()
+  {
+    ivNavigationPtr.reset(new FootstepNavigation(getNodeHandle(),
+                                                 getPrivateNodeHandle()));
+  }
+
+private:
+  boost::scoped_ptr<FootstepNavigation> ivNavigationPtr;
+};
+
+
+/// @brief FootstepPlannerWallsNode as nodelet.
+class FootstepPlannerWallsNodelet : public nodelet::Nodelet
+{
+public:
+  virtual void onInit()
+  {
+    ivNodePtr.reset(new FootstepPlannerWallsNode(getNodeHandle(),
+                                                 getPrivateNodeHandle()));
+  }
+
+private:
+  boost::scoped_ptr<FootstepPlannerWallsNode> ivNodePtr;
+};
+}
+
+PLUGINLIB_EXPORT_CLASS(footstep_planner::FootstepPlannerNodelet,
+                       nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(footstep_planner::FootstepNavigationNodelet,
+                       nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(footstep_planner::FootstepPlannerWallsNodelet,
+                       nodelet::Nodelet)
@@ -0,0 +1,91 @@
+/*
+ * A simple 2D gridmap structure
+ *
+ * Copyright 2011 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRIDMAP2D_GRIDMAP2DCACHE_H_
+#define GRIDMAP2D_GRIDMAP2DCACHE_H_
+
+#include <gridmap_2d/GridMap2D.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <list>
+
+
+namespace gridmap_2d{
+/**
+ * @brief Shares the GridMap2D of an OccupancyGrid message within a process.
+ *
+ * Nodelets in the same manager receive the same (immutable) message
+ * instance of a topic, so the GridMap2D (including its distance transform)
+ * only needs to be built by the first of them. The cache holds the messages
+ * and maps weakly, an entry expires with the last user of either one.
+ */
+class GridMap2DCache {
+public:
+  /**
+   * @return The GridMap2D of grid_map (created on the first request for
+   * this message instance). The map is shared and must not be modified,
+   * copy it for changes.
+   */
+  static GridMap2DConstPtr get(const nav_msgs::OccupancyGridConstPtr& grid_map,
+                               bool unknown_as_obstacle = false,
+                               int occupied_threshold = GridMap2D::DEFAULT_OCCUPIED_THRESHOLD);
+
+  /**
+   * @brief As get(), but a map created for grid_map is the successor of
+   * 'previous' (the caller's current map, may be empty), so that its
+   * changes since 'previous' are known (see GridMap2D::getChangesSince()).
+   * If the map was already created by another user, its journal continues
+   * the other user's map. The map has the distance map depth of 'previous'
+   * (see GridMap2D::setDistanceMapDepth()), maps of other depths are not
+   * shared.
+   */
+  static GridMap2DConstPtr get(const nav_msgs::OccupancyGridConstPtr& grid_map,
+                               const GridMap2DConstPtr& previous,
+                               bool unknown_as_obstacle = false,
+                               int occupied_threshold = GridMap2D::DEFAULT_OCCUPIED_THRESHOLD);
+
+private:
+  struct Entry{
+    boost::weak_ptr<const nav_msgs::OccupancyGrid> grid_map;
+    bool unknown_as_obstacle;
+    int occupied_threshold;
+    int dist_map_depth;
+    float dist_quantum;
+    boost::weak_ptr<const GridMap2D> map;
+  };
+
+  static boost::mutex m_mutex;
+  static std::list<Entry> m_entries;
+};
+}
+
+#endif /* GRIDMAP2D_GRIDMAP2DCACHE_H_ */
@@ -0,0 +1,187 @@
+/*
+ * A simple 2D gridmap structure
+ *
+ * Copyright 2011 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRIDMAP2D_GRIDMAP2DVIEW_H_
+#define GRIDMAP2D_GRIDMAP2DVIEW_H_
+
+#include <gridmap_2d/GridMap2D.h>
+
+#include <cstddef>
+
+
+namespace gridmap_2d{
+/**
+ * @brief Lightweight read-only access to the binary and distance map of a
+ * GridMap2D for inner loops.
+ *
+ * Keeps the origin, the reciprocal of the resolution and raw pointers to
+ * the cv::Mat data, so that accesses are inlined without a division or
+ * cv::Mat::at<>. Cell accessors and the ...NoBounds world accessors do not
+ * check the bounds. The view is only valid as long as the GridMap2D exists
+ * and its maps are not reallocated (setMap, inflateMap).
+ */
+class GridMap2DView {
+public:
+  GridMap2DView()
+  : m_originX(0.0), m_originY(0.0), m_resolution(0.0), m_invResolution(0.0),
+    m_width(0), m_height(0), m_binaryMap(NULL), m_distMap(NULL),
+    m_distMap8(NULL), m_distMap16(NULL), m_distQuantum(0.0f),
+    m_binaryStep(0), m_distStep(0)
+  {}
+
+  explicit GridMap2DView(const GridMap2D& map)
+  : m_originX(map.getInfo().origin.position.x),
+    m_originY(map.getInfo().origin.position.y),
+    m_resolution(map.getResolution()),
+    m_invResolution(1.0 / map.getResolution()),
+    m_width(map.getInfo().width), m_height(map.getInfo().height),
+    m_binaryMap(map.binaryMap().ptr<uchar>()),
+    m_distMap(NULL), m_distMap8(NULL), m_distMap16(NULL),
+    m_distQuantum(map.getDistanceQuantum()),
+    m_binaryStep(map.binaryMap().step1()),
+    m_distStep(0)
+  {
+    if (map.getDistanceMapDepth() == CV_8U){
+      m_distMap8 = map.quantizedDistanceMap().ptr<uchar>();
+      m_distStep = map.quantizedDistanceMap().step1();
+    } else if (map.getDistanceMapDepth() == CV_16U){
+      m_distMap16 = map.quantizedDistanceMap().ptr<ushort>();
+      m_distStep = map.quantizedDistanceMap().step1();
+    } else{
+      m_distMap = map.distanceMap().ptr<float>();
+      m_distStep = map.distanceMap().step1();
+    }
+  }
+
+  inline double getOriginX() const {return m_originX;}
+  inline double getOriginY() const {return m_originY;}
+  inline double getResolution() const {return m_resolution;}
+  /// @return 1 / resolution, to convert world to map coordinates
+  inline double getInvResolution() const {return m_invResolution;}
+  inline unsigned int getWidth() const {return m_width;}
+  inline unsigned int getHeight() const {return m_height;}
+
+  /// @return the binary map values of all cells <mx, *>
+  inline const uchar* binaryRow(unsigned int mx) const {
+    return m_binaryMap + mx * m_binaryStep;
+  }
+
+  /// @return the distances (in m) of all cells <mx, *>, only for a float
+  /// distance map (not quantized, see GridMap2D::setDistanceMapDepth)
+  inline const float* distanceRow(unsigned int mx) const {
+    return m_distMap + mx * m_distStep;
+  }
+
+  /// same as GridMap2D::worldToMapNoBounds
+  inline void worldToMapNoBounds(double wx, double wy, unsigned int& mx, unsigned int& my) const {
+    mx = (int) ((wx - m_originX) * m_invResolution);
+    my = (int) ((wy - m_originY) * m_invResolution);
+  }
+
+  /// same as GridMap2D::worldToMap
+  inline bool worldToMap(double wx, double wy, unsigned int& mx, unsigned int& my) const {
+    const double fx = (wx - m_originX) * m_invResolution;
+    const double fy = (wy - m_originY) * m_invResolution;
+    if (fx < 0.0 || fy < 0.0 || fx >= m_width || fy >= m_height)
+      return false;
+
+    mx = (unsigned int) fx;
+    my = (unsigned int) fy;
+    return true;
+  }
+
+  /// Distance (in m) at map cell <mx, my>, not bounds checked!
+  inline float distanceAtCell(unsigned int mx, unsigned int my) const {
+    if (m_distMap)
+      return m_distMap[mx * m_distStep + my];
+    else if (m_distMap8)
+      return m_distMap8[mx * m_distStep + my] * m_distQuantum;
+    else
+      return m_distMap16[mx * m_distStep + my] * m_distQuantum;
+  }
+
+  /// @return true if map cell <mx, my> is occupied, not bounds checked!
+  inline bool isOccupiedAtCell(unsigned int mx, unsigned int my) const {
+    return m_binaryMap[mx * m_binaryStep + my] < GridMap2D::FREE;
+  }
+
+  /// Distance (in m) at world coordinates <wx, wy>, not bounds checked!
+  inline float distanceAtNoBounds(double wx, double wy) const {
+    unsigned int mx, my;
+    worldToMapNoBounds(wx, wy, mx, my);
+    return distanceAtCell(mx, my);
+  }
+
+  /// Distance (in m) at world coordinates <wx, wy>; -1 if out of bounds!
+  inline float distanceAt(double wx, double wy) const {
+    unsigned int mx, my;
+    if (worldToMap(wx, wy, mx, my))
+      return distanceAtCell(mx, my);
+    else
+      return -1.0f;
+  }
+
+  /**
+   * @brief Samples the distance (in m) at the n world coordinates
+   * <xs[i], ys[i]> into out[i]; -1 if out of bounds!
+   */
+  inline void distanceAt(const float* xs, const float* ys, float* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = distanceAt(xs[i], ys[i]);
+  }
+
+  /// @return true if map is occupied at world coordinate <wx, wy>. Out of
+  /// bounds will be returned as occupied.
+  inline bool isOccupiedAt(double wx, double wy) const {
+    unsigned int mx, my;
+    if (worldToMap(wx, wy, mx, my))
+      return isOccupiedAtCell(mx, my);
+    else
+      return true;
+  }
+
+private:
+  double m_originX;
+  double m_originY;
+  double m_resolution;
+  double m_invResolution;
+  unsigned int m_width;   ///< number of cells in x (rows of the cv::Mat)
+  unsigned int m_height;  ///< number of cells in y (columns of the cv::Mat)
+  const uchar* m_binaryMap;
+  const float* m_distMap;      ///< float distance map, NULL if quantized
+  const uchar* m_distMap8;     ///< CV_8U quantized distance map or NULL
+  const ushort* m_distMap16;   ///< CV_16U quantized distance map or NULL
+  float m_distQuantum;
+  size_t m_binaryStep;    ///< elements per row of the binary map
+  size_t m_distStep;      ///< elements per row of the distance map
+};
+}
+
+#endif /* GRIDMAP2D_GRIDMAP2DVIEW_H_ */
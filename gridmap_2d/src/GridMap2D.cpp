@@ -31,25 +31,67 @@
 #include "gridmap_2d/GridMap2D.h"
 #include <ros/console.h>
 
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 namespace gridmap_2d{
 
+boost::mutex GridMap2D::s_revisionMutex;
+unsigned long GridMap2D::s_lastRevision = 0;
+
 GridMap2D::GridMap2D()
-: m_frameId("/map")
+: m_distMapDepth(CV_32F), m_distQuantum(0.0f), m_frameId("/map"),
+  m_unknownAsObstacle(false), m_occupiedThreshold(DEFAULT_OCCUPIED_THRESHOLD),
+  m_revision(0), m_journalBase(0)
 {
 
 }
 
-GridMap2D::GridMap2D(const nav_msgs::OccupancyGridConstPtr& gridMap, bool unknown_as_obstacle) {
+GridMap2D::GridMap2D(const nav_msgs::OccupancyGridConstPtr& gridMap, bool unknown_as_obstacle,
+                     int occupied_threshold)
+: m_distMapDepth(CV_32F), m_distQuantum(0.0f), m_unknownAsObstacle(false),
+  m_occupiedThreshold(DEFAULT_OCCUPIED_THRESHOLD), m_revision(0), m_journalBase(0)
+{
+
+  setMap(gridMap, unknown_as_obstacle, occupied_threshold);
+
+}
+
+GridMap2D::GridMap2D(const nav_msgs::OccupancyGridConstPtr& gridMap, const GridMap2D& previous,
+                     bool unknown_as_obstacle, int occupied_threshold)
+: m_binaryMap(previous.m_binaryMap), // replaced (not modified) by setMap
+  m_distMapDepth(previous.m_distMapDepth),
+  m_distQuantum(previous.m_distQuantum),
+  m_mapInfo(previous.m_mapInfo),
+  m_unknownAsObstacle(false),
+  m_occupiedThreshold(DEFAULT_OCCUPIED_THRESHOLD),
+  m_revision(previous.m_revision),
+  m_journalBase(previous.m_journalBase),
+  m_changes(previous.m_changes)
+{
 
-  setMap(gridMap, unknown_as_obstacle);
+  setMap(gridMap, unknown_as_obstacle, occupied_threshold);
 
 }
 
 GridMap2D::GridMap2D(const GridMap2D& other)
  : m_binaryMap(other.m_binaryMap.clone()),
    m_distMap(other.m_distMap.clone()),
+   m_quantizedDistMap(other.m_quantizedDistMap.clone()),
+   m_distMapDepth(other.m_distMapDepth),
+   m_distQuantum(other.m_distQuantum),
    m_mapInfo(other.m_mapInfo),
-   m_frameId(other.m_frameId)
+   m_frameId(other.m_frameId),
+   m_unknownAsObstacle(other.m_unknownAsObstacle),
+   m_occupiedThreshold(other.m_occupiedThreshold),
+   m_revision(other.m_revision),
+   m_journalBase(other.m_journalBase),
+   m_changes(other.m_changes),
+   m_closestObstacle(other.m_closestObstacle),
+   m_sqDist(other.m_sqDist),
+   m_raise(other.m_raise)
 {
 
 }
@@ -59,42 +101,360 @@ GridMap2D::~GridMap2D() {
 }
 
 void GridMap2D::updateDistanceMap(){
+  computeDistanceMap();
+  // manual changes of the binary map are unknown
+  recordUnknownChange();
+}
+
+void GridMap2D::computeDistanceMap(){
   cv::distanceTransform(m_binaryMap, m_distMap, CV_DIST_L2, CV_DIST_MASK_PRECISE);
   // distance map now contains distance in meters:
   m_distMap = m_distMap * m_mapInfo.resolution;
+
+  if (m_distMapDepth != CV_32F){
+    // rounded down to full quanta (as in setSquaredDistance), then saturated.
+    // The floor is explicit since convertTo rounds half to even.
+    cv::Mat quanta = m_distMap * (1.0 / m_distQuantum);
+    for (int i = 0; i < quanta.rows; ++i){
+      float* row = quanta.ptr<float>(i);
+      for (int j = 0; j < quanta.cols; ++j)
+        row[j] = std::floor(row[j]);
+    }
+    quanta.convertTo(m_quantizedDistMap, m_distMapDepth);
+    m_distMap.release();
+  } else{
+    m_quantizedDistMap.release();
+  }
+  clearInflatedBinaryMaps();
+
+  // incremental update data is outdated, re-initialized when needed
+  m_closestObstacle.clear();
+  m_sqDist.clear();
+  m_raise.clear();
+  m_open.clear();
+}
+
+void GridMap2D::setDistanceMapDepth(int depth, double max_distance){
+  // validated before anything is changed: a failed call keeps the map as it is
+  float quantum;
+  if (depth == CV_8U)
+    quantum = max_distance / std::numeric_limits<uchar>::max();
+  else if (depth == CV_16U)
+    quantum = max_distance / std::numeric_limits<ushort>::max();
+  else if (depth == CV_32F)
+    quantum = 0.0f;
+  else{
+    ROS_ERROR("GridMap2D: distance map depth %d not supported, keeping %d", depth, m_distMapDepth);
+    return;
+  }
+  if (depth != CV_32F && !(quantum > 0.0f)){
+    ROS_ERROR("GridMap2D: quantized distance map requires max_distance > 0, keeping depth %d", m_distMapDepth);
+    return;
+  }
+
+  m_distMapDepth = depth;
+  m_distQuantum = quantum;
+  if (!m_binaryMap.empty())
+    computeDistanceMap();
+}
+
+void GridMap2D::updateDistanceMap(const std::vector<cv::Point>& changed_cells){
+  clearInflatedBinaryMaps();
+
+  const int cols = m_binaryMap.cols;
+  const cv::Rect map_cells(0, 0, m_binaryMap.rows, cols);
+  cv::Rect changed_region;
+  std::vector<cv::Point>::const_iterator cell_iter;
+  for (cell_iter = changed_cells.begin(); cell_iter != changed_cells.end();
+       ++cell_iter)
+  {
+    if (map_cells.contains(*cell_iter))
+      changed_region |= cv::Rect(*cell_iter, cv::Size(1, 1));
+  }
+  if (changed_region.area() > 0)
+    recordChange(std::vector<cv::Rect>(1, changed_region));
+
+  if (m_closestObstacle.size() != m_binaryMap.total()){
+    // initialized from the current binary map, including the changes
+    initIncrementalDistanceMap();
+    return;
+  }
+
+  for (cell_iter = changed_cells.begin(); cell_iter != changed_cells.end();
+       ++cell_iter)
+  {
+    if (cell_iter->x < 0 || cell_iter->x >= m_binaryMap.rows ||
+        cell_iter->y < 0 || cell_iter->y >= cols)
+      continue;
+
+    const int idx = cell_iter->x * cols + cell_iter->y;
+    const bool obstacle =
+      m_binaryMap.at<uchar>(cell_iter->x, cell_iter->y) == OCCUPIED;
+    if (obstacle && m_closestObstacle[idx] != idx){
+      // new obstacle: lower the distances around it
+      m_closestObstacle[idx] = idx;
+      m_raise[idx] = false;
+      setSquaredDistance(idx, 0);
+      m_open.push_back(std::make_pair(0, idx));
+      std::push_heap(m_open.begin(), m_open.end(),
+                     std::greater<std::pair<int, int> >());
+    }
+    else if (!obstacle && m_closestObstacle[idx] == idx){
+      // removed obstacle: clear the cells it was closest to
+      m_closestObstacle[idx] = -1;
+      m_raise[idx] = true;
+      setSquaredDistance(idx, std::numeric_limits<int>::max());
+      m_open.push_back(std::make_pair(0, idx));
+      std::push_heap(m_open.begin(), m_open.end(),
+                     std::greater<std::pair<int, int> >());
+    }
+  }
+
+  propagateDistanceChanges();
+}
+
+void GridMap2D::updateDistanceMap(const cv::Rect& changed_region){
+  const cv::Rect region =
+    changed_region & cv::Rect(0, 0, m_binaryMap.rows, m_binaryMap.cols);
+
+  std::vector<cv::Point> changed_cells;
+  changed_cells.reserve(region.area());
+  for (int mx = region.x; mx < region.x + region.width; ++mx){
+    for (int my = region.y; my < region.y + region.height; ++my)
+      changed_cells.push_back(cv::Point(mx, my));
+  }
+
+  updateDistanceMap(changed_cells);
+}
+
+void GridMap2D::initIncrementalDistanceMap(){
+  const int num_cells = m_binaryMap.total();
+  m_closestObstacle.assign(num_cells, -1);
+  m_sqDist.assign(num_cells, std::numeric_limits<int>::max());
+  m_raise.assign(num_cells, false);
+  m_open.clear();
+  if (m_distMapDepth == CV_8U)
+    m_quantizedDistMap.setTo(std::numeric_limits<uchar>::max());
+  else if (m_distMapDepth == CV_16U)
+    m_quantizedDistMap.setTo(std::numeric_limits<ushort>::max());
+  else
+    m_distMap.setTo(std::numeric_limits<float>::max());
+
+  // brushfire from all obstacles
+  for (int idx = 0; idx < num_cells; ++idx){
+    if (m_binaryMap.at<uchar>(idx / m_binaryMap.cols,
+                              idx % m_binaryMap.cols) == OCCUPIED)
+    {
+      m_closestObstacle[idx] = idx;
+      setSquaredDistance(idx, 0);
+      m_open.push_back(std::make_pair(0, idx));
+    }
+  }
+  std::make_heap(m_open.begin(), m_open.end(),
+                 std::greater<std::pair<int, int> >());
+
+  propagateDistanceChanges();
+}
+
+void GridMap2D::propagateDistanceChanges(){
+  const int rows = m_binaryMap.rows;
+  const int cols = m_binaryMap.cols;
+
+  while (!m_open.empty()){
+    std::pop_heap(m_open.begin(), m_open.end(),
+                  std::greater<std::pair<int, int> >());
+    const int sq_dist = m_open.back().first;
+    const int idx = m_open.back().second;
+    m_open.pop_back();
+
+    const int r = idx / cols;
+    const int c = idx % cols;
+
+    if (m_raise[idx]){
+      // raise: clear all neighbors whose closest obstacle vanished and
+      // queue the remaining ones to lower the cleared cells again
+      for (int nr = std::max(r - 1, 0); nr <= std::min(r + 1, rows - 1); ++nr){
+        for (int nc = std::max(c - 1, 0); nc <= std::min(c + 1, cols - 1); ++nc){
+          const int n = nr * cols + nc;
+          const int obst_n = m_closestObstacle[n];
+          if (n == idx || obst_n < 0 || m_raise[n])
+            continue;
+
+          m_open.push_back(std::make_pair(m_sqDist[n], n));
+          std::push_heap(m_open.begin(), m_open.end(),
+                         std::greater<std::pair<int, int> >());
+          if (m_binaryMap.at<uchar>(obst_n / cols, obst_n % cols) != OCCUPIED){
+            m_closestObstacle[n] = -1;
+            m_raise[n] = true;
+            setSquaredDistance(n, std::numeric_limits<int>::max());
+          }
+        }
+      }
+      m_raise[idx] = false;
+    }
+    else{
+      // lower: skip outdated entries and cells without a valid obstacle
+      const int obst = m_closestObstacle[idx];
+      if (sq_dist != m_sqDist[idx] || obst < 0 ||
+          m_binaryMap.at<uchar>(obst / cols, obst % cols) != OCCUPIED)
+        continue;
+
+      const int obst_r = obst / cols;
+      const int obst_c = obst % cols;
+      for (int nr = std::max(r - 1, 0); nr <= std::min(r + 1, rows - 1); ++nr){
+        for (int nc = std::max(c - 1, 0); nc <= std::min(c + 1, cols - 1); ++nc){
+          const int n = nr * cols + nc;
+          if (n == idx || m_raise[n])
+            continue;
+
+          const int new_sq_dist =
+            (nr - obst_r) * (nr - obst_r) + (nc - obst_c) * (nc - obst_c);
+          const int obst_n = m_closestObstacle[n];
+          if (new_sq_dist < m_sqDist[n] ||
+              (new_sq_dist == m_sqDist[n] &&
+               (obst_n < 0 ||
+                m_binaryMap.at<uchar>(obst_n / cols, obst_n % cols) != OCCUPIED)))
+          {
+            m_closestObstacle[n] = obst;
+            setSquaredDistance(n, new_sq_dist);
+            m_open.push_back(std::make_pair(new_sq_dist, n));
+            std::push_heap(m_open.begin(), m_open.end(),
+                           std::greater<std::pair<int, int> >());
+          }
+        }
+      }
+    }
+  }
+}
+
+void GridMap2D::setSquaredDistance(int idx, int sq_dist){
+  m_sqDist[idx] = sq_dist;
+  const int mx = idx / m_binaryMap.cols;
+  const int my = idx % m_binaryMap.cols;
+  if (m_distMapDepth == CV_32F){
+    float& dist = m_distMap.at<float>(mx, my);
+    if (sq_dist == std::numeric_limits<int>::max())
+      dist = std::numeric_limits<float>::max();
+    else
+      dist = sqrt(float(sq_dist)) * m_mapInfo.resolution;
+    return;
+  }
+
+  // quantized: rounded down and saturated as in computeDistanceMap()
+  double quanta = std::numeric_limits<double>::max();
+  if (sq_dist != std::numeric_limits<int>::max())
+    quanta = floor(sqrt(double(sq_dist)) * m_mapInfo.resolution / m_distQuantum);
+  if (m_distMapDepth == CV_8U)
+    m_quantizedDistMap.at<uchar>(mx, my) = cv::saturate_cast<uchar>(quanta);
+  else
+    m_quantizedDistMap.at<ushort>(mx, my) = cv::saturate_cast<ushort>(quanta);
 }
 
-void GridMap2D::setMap(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle){
+GridMap2D::OccupancyConversion::OccupancyConversion(const cv::Mat& occupancy,
+                                                    const cv::Mat& lut,
+                                                    cv::Mat& binary_map)
+: m_occupancy(occupancy), m_lut(lut), m_binaryMap(binary_map)
+{}
+
+void GridMap2D::OccupancyConversion::operator()(const cv::Range& rows) const{
+  // strips of rows small enough to stay in the cache between the
+  // threshold and the transpose
+  const int strip_rows = 64;
+  cv::Mat strip;
+  for (int j = rows.start; j < rows.end; j += strip_rows){
+    const cv::Range strip_range(j, std::min(j + strip_rows, rows.end));
+    cv::LUT(m_occupancy.rowRange(strip_range), m_lut, strip);
+    cv::Mat binary_cols = m_binaryMap.colRange(strip_range);
+    cv::transpose(strip, binary_cols);
+  }
+}
+
+void GridMap2D::setMap(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle,
+                       int occupied_threshold){
+  const cv::Mat previous_map = m_binaryMap;
+  const nav_msgs::MapMetaData previous_info = m_mapInfo;
   m_mapInfo = grid_map->info;
   m_frameId = grid_map->header.frame_id;
+  m_unknownAsObstacle = unknown_as_obstacle;
+  m_occupiedThreshold = occupied_threshold;
   // allocate map structs so that x/y in the world correspond to x/y in the image
   // (=> cv::Mat is rotated by 90 deg, because it's row-major!)
   m_binaryMap = cv::Mat(m_mapInfo.width, m_mapInfo.height, CV_8UC1);
   m_distMap = cv::Mat(m_binaryMap.size(), CV_32FC1);
 
-  std::vector<signed char>::const_iterator mapDataIter = grid_map->data.begin();
+  const cv::Mat occupancy_lut = occupancyLut();
+
+  // (0,0) is lower left corner of OccupancyGrid, its rows (y) are stored
+  // as columns in the image. Wrap the data without copying it, then
+  // threshold and transpose it in parallel strips of rows.
+  if (!grid_map->data.empty()){
+    const cv::Mat occupancy(m_mapInfo.height, m_mapInfo.width, CV_8UC1,
+                            const_cast<signed char*>(&grid_map->data[0]));
+    cv::parallel_for_(cv::Range(0, occupancy.rows),
+                      OccupancyConversion(occupancy, occupancy_lut, m_binaryMap));
+  }
 
-  //TODO check / param
-  unsigned char map_occ_thres = 70;
+  computeDistanceMap();
+  recordChanges(previous_map, previous_info);
 
-  // iterate over map, store in image
-  // (0,0) is lower left corner of OccupancyGrid
-  for(unsigned int j = 0; j < m_mapInfo.height; ++j){
-    for(unsigned int i = 0; i < m_mapInfo.width; ++i){
-      if (*mapDataIter > map_occ_thres
-          || (unknown_as_obstacle && *mapDataIter < 0))
-      {
-        m_binaryMap.at<uchar>(i,j) = OCCUPIED;
-      } else{
-        m_binaryMap.at<uchar>(i,j) = FREE;
+  ROS_INFO("GridMap2D created with %d x %d cells at %f resolution.", m_mapInfo.width, m_mapInfo.height, m_mapInfo.resolution);
+}
+
+cv::Mat GridMap2D::occupancyLut() const{
+  cv::Mat occupancy_lut(1, 256, CV_8UC1);
+  for (int i = 0; i < 256; ++i){
+    const signed char occupancy = (signed char)(i);
+    if (occupancy > m_occupiedThreshold
+        || (m_unknownAsObstacle && occupancy < 0))
+      occupancy_lut.at<uchar>(i) = OCCUPIED;
+    else
+      occupancy_lut.at<uchar>(i) = FREE;
+  }
+
+  return occupancy_lut;
+}
+
+bool GridMap2D::applyUpdate(const map_msgs::OccupancyGridUpdateConstPtr& update){
+  // compare in 64 bit, x + width could overflow otherwise:
+  const long x = update->x;
+  const long y = update->y;
+  if (x < 0 || y < 0
+      || x + long(update->width) > long(m_mapInfo.width)
+      || y + long(update->height) > long(m_mapInfo.height)){
+    ROS_WARN("Map update [%d, %d] (%u x %u) is outside of the %u x %u map, ignoring it.",
+             update->x, update->y, update->width, update->height,
+             m_mapInfo.width, m_mapInfo.height);
+    return false;
+  }
+  if (update->data.size() != size_t(update->width) * update->height){
+    ROS_WARN("Map update has %u cells instead of %u x %u, ignoring it.",
+             (unsigned int)(update->data.size()), update->width, update->height);
+    return false;
+  }
+
+  const cv::Mat occupancy_lut = occupancyLut();
+  const uchar* lut = occupancy_lut.ptr<uchar>(0);
+
+  // rows (y) of the update are columns of the binary map, see setMap()
+  std::vector<cv::Point> changed_cells;
+  for (unsigned int j = 0; j < update->height; ++j){
+    const signed char* occupancy = &update->data[size_t(j) * update->width];
+    const unsigned int my = update->y + j;
+    for (unsigned int i = 0; i < update->width; ++i){
+      const unsigned int mx = update->x + i;
+      const uchar value = lut[uchar(occupancy[i])];
+      uchar& cell = m_binaryMap.at<uchar>(mx, my);
+      if (cell != value){
+        cell = value;
+        changed_cells.push_back(cv::Point(mx, my));
       }
-      ++mapDataIter;
     }
   }
 
-  updateDistanceMap();
+  if (!changed_cells.empty())
+    updateDistanceMap(changed_cells);
 
-  ROS_INFO("GridMap2D created with %d x %d cells at %f resolution.", m_mapInfo.width, m_mapInfo.height, m_mapInfo.resolution);
+  return true;
 }
 
 nav_msgs::OccupancyGrid GridMap2D::toOccupancyGridMsg() const{
@@ -122,22 +482,132 @@ nav_msgs::OccupancyGrid GridMap2D::toOccupancyGridMsg() const{
 }
 
 void GridMap2D::setMap(const cv::Mat& binaryMap){
+  const cv::Mat previous_map = m_binaryMap;
   m_binaryMap = binaryMap.clone();
   m_distMap = cv::Mat(m_binaryMap.size(), CV_32FC1);
 
-  cv::distanceTransform(m_binaryMap, m_distMap, CV_DIST_L2, CV_DIST_MASK_PRECISE);
-  // distance map now contains distance in meters:
-  m_distMap = m_distMap * m_mapInfo.resolution;
+  computeDistanceMap();
+  recordChanges(previous_map, m_mapInfo);
 
   ROS_INFO("GridMap2D copied from existing cv::Mat with %d x %d cells at %f resolution.", m_mapInfo.width, m_mapInfo.height, m_mapInfo.resolution);
 
 }
 
 void GridMap2D::inflateMap(double inflationRadius){
-  m_binaryMap = (m_distMap > inflationRadius );
+  const cv::Mat previous_map = m_binaryMap;
+  m_binaryMap = inflatedBinaryMap(inflationRadius).clone();
   // recompute distance map with new binary map:
-  cv::distanceTransform(m_binaryMap, m_distMap, CV_DIST_L2, CV_DIST_MASK_PRECISE);
-  m_distMap = m_distMap * m_mapInfo.resolution;
+  computeDistanceMap();
+  recordChanges(previous_map, m_mapInfo);
+}
+
+bool GridMap2D::getChangesSince(unsigned long revision,
+                                std::vector<cv::Rect>& changed_regions) const{
+  changed_regions.clear();
+  if (revision == m_revision)
+    return true;
+
+  std::deque<MapChange>::const_iterator change_iter = m_changes.begin();
+  if (revision != m_journalBase){
+    while (change_iter != m_changes.end() && change_iter->revision != revision)
+      ++change_iter;
+    if (change_iter == m_changes.end())
+      return false;
+    ++change_iter;
+  }
+
+  for (; change_iter != m_changes.end(); ++change_iter)
+    changed_regions.insert(changed_regions.end(),
+                           change_iter->regions.begin(),
+                           change_iter->regions.end());
+  return true;
+}
+
+unsigned long GridMap2D::nextRevision(){
+  boost::mutex::scoped_lock lock(s_revisionMutex);
+  return ++s_lastRevision;
+}
+
+void GridMap2D::recordChanges(const cv::Mat& previous_map,
+                              const nav_msgs::MapMetaData& previous_info){
+  if (previous_map.size() != m_binaryMap.size()
+      || previous_info.resolution != m_mapInfo.resolution
+      || previous_info.origin.position.x != m_mapInfo.origin.position.x
+      || previous_info.origin.position.y != m_mapInfo.origin.position.y)
+  {
+    recordUnknownChange();
+    return;
+  }
+
+  // changed blocks of cells, merged along y (columns)
+  const int block_size = CHANGE_BLOCK_SIZE;
+  const cv::Mat changed = (previous_map != m_binaryMap);
+  std::vector<cv::Rect> changed_regions;
+  for (int x = 0; x < changed.rows; x += block_size){
+    const int block_rows = std::min(block_size, changed.rows - x);
+    int run_start = -1;
+    for (int y = 0; y < changed.cols; y += block_size){
+      const int block_cols = std::min(block_size, changed.cols - y);
+      const cv::Mat block = changed(cv::Range(x, x + block_rows),
+                                    cv::Range(y, y + block_cols));
+      if (cv::countNonZero(block) > 0){
+        if (run_start < 0)
+          run_start = y;
+      } else if (run_start >= 0){
+        changed_regions.push_back(cv::Rect(x, run_start, block_rows, y - run_start));
+        run_start = -1;
+      }
+    }
+    if (run_start >= 0)
+      changed_regions.push_back(cv::Rect(x, run_start, block_rows, changed.cols - run_start));
+  }
+
+  if (!changed_regions.empty())
+    recordChange(changed_regions);
+}
+
+void GridMap2D::recordChange(const std::vector<cv::Rect>& changed_regions){
+  MapChange change;
+  change.revision = nextRevision();
+  change.regions = changed_regions;
+  m_changes.push_back(change);
+  m_revision = change.revision;
+
+  if (m_changes.size() > MAX_JOURNAL_SIZE){
+    m_journalBase = m_changes.front().revision;
+    m_changes.pop_front();
+  }
+}
+
+void GridMap2D::recordUnknownChange(){
+  m_revision = nextRevision();
+  m_journalBase = m_revision;
+  m_changes.clear();
+}
+
+cv::Mat GridMap2D::inflatedBinaryMap(double radius) const{
+  boost::mutex::scoped_lock lock(m_inflatedBinaryMapsMutex);
+
+  std::map<double, cv::Mat>::const_iterator it = m_inflatedBinaryMaps.find(radius);
+  if (it != m_inflatedBinaryMaps.end())
+    return it->second;
+
+  cv::Mat inflated;
+  if (m_distMapDepth == CV_32F)
+    inflated = (m_distMap > radius);
+  else{
+    cv::Mat dist;
+    m_quantizedDistMap.convertTo(dist, CV_32F, m_distQuantum);
+    inflated = (dist > radius);
+  }
+  m_inflatedBinaryMaps[radius] = inflated;
+
+  return inflated;
+}
+
+void GridMap2D::clearInflatedBinaryMaps(){
+  boost::mutex::scoped_lock lock(m_inflatedBinaryMapsMutex);
+  m_inflatedBinaryMaps.clear();
 }
 
 // See costmap2D for mapToWorld / worldToMap implementations:
@@ -176,7 +646,7 @@ float GridMap2D::distanceMapAt(double wx, double wy) const{
   unsigned mx, my;
 
   if (worldToMap(wx, wy, mx, my))
-    return m_distMap.at<float>(mx, my);
+    return distanceMapAtCell(mx, my);
   else
     return -1.0f;
 }
@@ -192,7 +662,12 @@ uchar GridMap2D::binaryMapAt(double wx, double wy) const{
 }
 
 float GridMap2D::distanceMapAtCell(unsigned int mx, unsigned int my) const{
-  return m_distMap.at<float>(mx, my);
+  if (m_distMapDepth == CV_32F)
+    return m_distMap.at<float>(mx, my);
+  else if (m_distMapDepth == CV_8U)
+    return m_quantizedDistMap.at<uchar>(mx, my) * m_distQuantum;
+  else
+    return m_quantizedDistMap.at<ushort>(mx, my) * m_distQuantum;
 }
 
 
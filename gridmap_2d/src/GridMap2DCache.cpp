@@ -0,0 +1,91 @@
+/*
+ * A simple 2D gridmap structure
+ *
+ * Copyright 2011 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gridmap_2d/GridMap2DCache.h"
+
+namespace gridmap_2d{
+
+boost::mutex GridMap2DCache::m_mutex;
+std::list<GridMap2DCache::Entry> GridMap2DCache::m_entries;
+
+GridMap2DConstPtr GridMap2DCache::get(const nav_msgs::OccupancyGridConstPtr& grid_map,
+                                      bool unknown_as_obstacle,
+                                      int occupied_threshold){
+  return get(grid_map, GridMap2DConstPtr(), unknown_as_obstacle, occupied_threshold);
+}
+
+GridMap2DConstPtr GridMap2DCache::get(const nav_msgs::OccupancyGridConstPtr& grid_map,
+                                      const GridMap2DConstPtr& previous,
+                                      bool unknown_as_obstacle,
+                                      int occupied_threshold){
+  // the lock is held while a map is built, so that concurrent requests for
+  // the same message wait for it instead of building it again
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  // a successor keeps the distance map depth of 'previous'
+  const int dist_map_depth = previous ? previous->getDistanceMapDepth() : CV_32F;
+  const float dist_quantum = previous ? previous->getDistanceQuantum() : 0.0f;
+
+  std::list<Entry>::iterator it = m_entries.begin();
+  while (it != m_entries.end()){
+    GridMap2DConstPtr map = it->map.lock();
+    nav_msgs::OccupancyGridConstPtr msg = it->grid_map.lock();
+    if (!map || !msg){
+      it = m_entries.erase(it);
+      continue;
+    }
+    if (msg == grid_map && it->unknown_as_obstacle == unknown_as_obstacle
+        && it->occupied_threshold == occupied_threshold
+        && it->dist_map_depth == dist_map_depth
+        && it->dist_quantum == dist_quantum)
+      return map;
+    ++it;
+  }
+
+  GridMap2DConstPtr map;
+  if (previous)
+    map.reset(new GridMap2D(grid_map, *previous, unknown_as_obstacle,
+                            occupied_threshold));
+  else
+    map.reset(new GridMap2D(grid_map, unknown_as_obstacle,
+                            occupied_threshold));
+  Entry entry;
+  entry.grid_map = grid_map;
+  entry.unknown_as_obstacle = unknown_as_obstacle;
+  entry.occupied_threshold = occupied_threshold;
+  entry.dist_map_depth = dist_map_depth;
+  entry.dist_quantum = dist_quantum;
+  entry.map = map;
+  m_entries.push_back(entry);
+
+  return map;
+}
+
+}
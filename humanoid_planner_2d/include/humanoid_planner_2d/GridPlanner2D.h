@@ -0,0 +1,191 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HUMANOID_PLANNER_2D_GRID_PLANNER_2D_
+#define HUMANOID_PLANNER_2D_GRID_PLANNER_2D_
+
+#include <opencv2/core/core.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+
+/**
+ * @brief Native 8-connected 2D grid planner (jump point search) on a flat
+ * copy of an inflated binary map, without SBPL. Diagonal moves may not cut
+ * corners of obstacles. Costs are in cells (1 per straight, sqrt(2) per
+ * diagonal move), cells are cv::Point(mx, my).
+ *
+ * All queries are const except for plan(), so batches of queries can be
+ * answered concurrently (planBatch()).
+ */
+class GridPlanner2D {
+public:
+  struct Query {
+    Query() : start(0, 0), goal(0, 0) {}
+    Query(const cv::Point& start, const cv::Point& goal) : start(start), goal(goal) {}
+    cv::Point start;
+    cv::Point goal;
+  };
+
+  struct Result {
+    Result() : success(false), cost(0.0) {}
+    bool success;
+    double cost;                  ///< in cells
+    std::vector<cv::Point> path;  ///< all cells from start to goal
+  };
+
+  GridPlanner2D();
+  virtual ~GridPlanner2D();
+
+  /**
+   * @brief Copies the map (as from gridmap_2d::GridMap2D::inflatedBinaryMap(),
+   * i.e. rows: mx, cols: my) into the planning grid and labels its connected
+   * free regions.
+   */
+  void setMap(const cv::Mat& inflated_map);
+
+  /// @return true if goal can be reached from start (O(1), without search)
+  bool isReachable(const cv::Point& start, const cv::Point& goal) const;
+
+  /// @brief Plans from start to goal (not thread-safe, see planBatch()).
+  bool plan(const cv::Point& start, const cv::Point& goal, std::vector<cv::Point>& path, double& cost);
+
+  /// @brief Answers all queries, in parallel with OpenCV's threads.
+  void planBatch(const std::vector<Query>& queries, std::vector<Result>& results) const;
+
+  /**
+   * @brief Costs (in cells) from each source to each target, row-major
+   * (distances[i * targets.size() + j]), -1 if unreachable. Runs one
+   * Dijkstra per source (in parallel) over the whole free region, the
+   * resulting distance fields are reused until the next setMap() (see
+   * setDistanceFieldCacheSize()). Missing fields are computed in batches
+   * of at most the cache size (at least one field), so besides the cache
+   * only one batch of fields is held for any number of sources.
+   */
+  void distanceMatrix(const std::vector<cv::Point>& sources, const std::vector<cv::Point>& targets,
+                      std::vector<double>& distances) const;
+
+  /**
+   * @brief Limits the memory of the cached distance fields (4 bytes per
+   * cell of the map each) to max_bytes, the oldest ones are dropped first.
+   * 0 disables the cache.
+   */
+  void setDistanceFieldCacheSize(size_t max_bytes);
+  inline size_t getDistanceFieldCacheSize() const {return distance_field_cache_size_;}
+
+  static const size_t DEFAULT_DISTANCE_FIELD_CACHE_SIZE = 256 * 1024 * 1024;
+
+  inline int getWidth() const {return width_;}
+  inline int getHeight() const {return height_;}
+
+protected:
+  /// search data of one thread, reset per query by increasing 'generation'
+  struct SearchState {
+    SearchState() : generation(0) {}
+    void reset(size_t num_cells);
+    unsigned int generation;
+    std::vector<unsigned int> seen;   ///< generation in which g / parent were set
+    std::vector<unsigned int> closed; ///< generation in which the cell was expanded
+    std::vector<double> g;
+    std::vector<int> parent;
+  };
+
+  class BatchPlanning : public cv::ParallelLoopBody {
+  public:
+    BatchPlanning(const GridPlanner2D& planner, const std::vector<Query>& queries, std::vector<Result>& results);
+    virtual void operator()(const cv::Range& range) const;
+  private:
+    const GridPlanner2D& planner_;
+    const std::vector<Query>& queries_;
+    std::vector<Result>& results_;
+  };
+
+  /// costs (in cells) of all cells from one source, FLT_MAX if unreachable
+  typedef std::vector<float> DistanceField;
+  typedef boost::shared_ptr<const DistanceField> DistanceFieldConstPtr;
+
+  class DistanceFieldComputation : public cv::ParallelLoopBody {
+  public:
+    DistanceFieldComputation(const GridPlanner2D& planner, const std::vector<int>& sources,
+                             std::vector<DistanceFieldConstPtr>& fields);
+    virtual void operator()(const cv::Range& range) const;
+  private:
+    const GridPlanner2D& planner_;
+    const std::vector<int>& sources_;
+    std::vector<DistanceFieldConstPtr>& fields_;
+  };
+
+  /// @brief Dijkstra from source (index) to all cells of its free region
+  void computeDistanceField(int source, DistanceField& field) const;
+  /// @brief copies the distances to all targets from field to row source of distances
+  void copyDistances(const DistanceField& field, size_t source, const std::vector<cv::Point>& targets,
+                     std::vector<double>& distances) const;
+  /// @brief drops the oldest distance fields above the cache size, needs distance_fields_mutex_
+  void evictDistanceFields() const;
+
+  bool search(SearchState& state, const cv::Point& start, const cv::Point& goal,
+              std::vector<cv::Point>& path, double& cost) const;
+  /// @return the jump point from idx in direction (dx, dy), or -1
+  int jump(int idx, int dx, int dy, int goal) const;
+  /// @return the jump point from idx straight in direction (dx, dy), or -1
+  int jumpStraight(int idx, int dx, int dy, int goal) const;
+  /// @brief adds the successor directions of idx, reached from parent (-1: none)
+  void successorDirections(int idx, int parent, std::vector<cv::Point>& directions) const;
+  double heuristic(int idx, int goal) const;
+
+  inline bool inGrid(const cv::Point& cell) const {
+    return cell.x >= 0 && cell.y >= 0 && cell.x < width_ && cell.y < height_;
+  }
+  /// index of map cell (mx, my) in the padded grid (contiguous along my)
+  inline int index(int mx, int my) const {return (mx + 1) * stride_ + my + 1;}
+  inline int index(const cv::Point& cell) const {return index(cell.x, cell.y);}
+  inline cv::Point cell(int idx) const {return cv::Point(idx / stride_ - 1, idx % stride_ - 1);}
+  inline bool isFree(int idx) const {return free_[idx] != 0;}
+  inline bool isFree(int idx, int dx, int dy) const {return free_[idx + dx * stride_ + dy] != 0;}
+
+  int width_;   ///< size of the map in x (mx)
+  int height_;  ///< size of the map in y (my)
+  int stride_;  ///< height_ + 2, rows are padded by one occupied cell
+  std::vector<unsigned char> free_; ///< 1 for free cells, padded by one occupied cell on each side
+  std::vector<int> component_;      ///< connected free region of each cell, -1 if occupied
+  SearchState state_;               ///< used by plan()
+
+  /// distance fields by source index, oldest first in distance_field_order_
+  mutable std::map<int, DistanceFieldConstPtr> distance_fields_;
+  mutable std::deque<int> distance_field_order_;
+  mutable size_t distance_fields_bytes_;  ///< memory of distance_fields_
+  mutable boost::mutex distance_fields_mutex_;
+  size_t distance_field_cache_size_;      ///< in bytes
+};
+
+#endif
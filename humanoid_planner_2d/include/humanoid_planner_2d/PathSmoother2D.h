@@ -0,0 +1,87 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HUMANOID_PLANNER_2D_PATH_SMOOTHER_2D_
+#define HUMANOID_PLANNER_2D_PATH_SMOOTHER_2D_
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+
+/**
+ * @brief Compresses a path of grid cells into few waypoints by line-of-sight
+ * shortcuts and rounds its corners with circular arcs, only where the result
+ * stays free in the inflated map.
+ *
+ * Waypoints are continuous map coordinates in cells, i.e. the center of cell
+ * (mx, my) is (mx + 0.5, my + 0.5).
+ */
+class PathSmoother2D {
+public:
+  PathSmoother2D();
+  virtual ~PathSmoother2D();
+
+  /// @brief Sets the inflated map (rows: mx, cols: my) to check the path against.
+  void setMap(const cv::Mat& inflated_map);
+
+  /// @brief Corners are rounded with this radius (in cells) if there is enough
+  /// space and kept otherwise. 0 disables the smoothing.
+  void setTurningRadius(double radius) {turning_radius_ = radius;}
+
+  /// @brief shortcut() followed by smooth()
+  void process(const std::vector<cv::Point>& cells, std::vector<cv::Point2d>& waypoints) const;
+
+  /// @brief Keeps only the cells where the path has to turn to stay free.
+  void shortcut(const std::vector<cv::Point>& cells, std::vector<cv::Point2d>& waypoints) const;
+
+  /// @brief Replaces corners of the waypoints by sampled arcs of the turning
+  /// radius where they fit and are free.
+  void smooth(std::vector<cv::Point2d>& waypoints) const;
+
+  /**
+   * @return true if all cells touched by the line between 'from' and 'to'
+   * are free. Lines through the corner of two cells need both to be free.
+   */
+  bool lineOfSight(const cv::Point2d& from, const cv::Point2d& to) const;
+
+  /// @return the length of the waypoint polyline (in cells)
+  static double length(const std::vector<cv::Point2d>& waypoints);
+
+protected:
+  inline bool isFree(int mx, int my) const {
+    return mx >= 0 && my >= 0 && mx < inflated_map_.rows && my < inflated_map_.cols
+        && inflated_map_.at<uchar>(mx, my) != 0;
+  }
+
+  cv::Mat inflated_map_;  ///< shared, read-only
+  double turning_radius_; ///< in cells
+  static const double MAX_ARC_STEP; ///< max. angle between arc samples (rad)
+};
+
+#endif
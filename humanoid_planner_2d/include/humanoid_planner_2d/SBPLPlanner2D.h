@@ -36,6 +36,10 @@
 #include <visualization_msgs/Marker.h>
 #include <nav_msgs/Path.h>
 #include <gridmap_2d/GridMap2D.h>
+#include <humanoid_planner_2d/DistanceMatrix.h>
+#include <humanoid_planner_2d/GridPlanner2D.h>
+#include <humanoid_planner_2d/PathSmoother2D.h>
+#include <map_msgs/OccupancyGridUpdate.h>
 
 
 class SBPLPlanner2D {
@@ -48,9 +52,28 @@ public:
   void startCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& start);
   /// calls updateMap()
   void mapCallback(const nav_msgs::OccupancyGridConstPtr& occupancy_map);
-  /// Setup the internal map representation and initialize the SBPL planning environment
+  /// patches a copy of the current map (see GridMap2D::applyUpdate) and calls updateMap()
+  void mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& map_update);
+  /**
+   * @brief Setup the internal map representation and initialize the SBPL
+   * planning environment. If the environment already covers a map of the
+   * same size and only a few cells of the inflated map changed, only these
+   * costs are updated and the planner is notified (costs_changed) instead.
+   * The distance map of 'map' is converted to the configured depth
+   * (parameter distance_map_depth) if needed.
+   */
   bool updateMap(gridmap_2d::GridMap2DPtr map);
 
+  /**
+   * @brief Service 'distance_matrix': walking distances (path costs in m)
+   * from all sources to all targets on the inflated map, see
+   * GridPlanner2D::distanceMatrix(). The distance fields are kept until
+   * the map revision changes.
+   */
+  bool distanceMatrixService(humanoid_planner_2d::DistanceMatrix::Request& req,
+                             humanoid_planner_2d::DistanceMatrix::Response& resp);
+
+  /// @return the map set with updateMap() (not inflated)
   gridmap_2d::GridMap2DPtr getMap() const { return map_;};
 
   /**
@@ -76,16 +99,47 @@ public:
 
   inline const nav_msgs::Path& getPath() const{return path_;};
   inline double getRobotRadius() const{return robot_radius_;};
+  /// @return the native grid planner (planner_type "GridPlanner2D", e.g. for batch queries), NULL otherwise
+  inline const GridPlanner2D* getGridPlanner() const{return grid_planner_.get();};
 
 protected:
   bool plan();
   void setPlanner(); ///< (re)sets the planner
+  /// creates the planning environment from all costs of inflated_map and (re)sets the planner
+  void initializeEnvironment(const cv::Mat& inflated_map);
+  /**
+   * @brief Updates the costs of the cells that differ between inflated_map_
+   * and inflated_map (of 'map', changed since map_revision_) in the
+   * current environment.
+   *
+   * @return false if too many cells changed, the environment needs to be
+   * initialized again then.
+   */
+  bool updateEnvironment(const gridmap_2d::GridMap2DPtr& map, const cv::Mat& inflated_map);
+
+  /// IDs of states with changed edges, for SBPLPlanner::costs_changed()
+  class ChangedStatesQuery : public StateChangeQuery {
+  public:
+    ChangedStatesQuery(const std::vector<int>& states) : states_(states) {}
+    virtual const std::vector<int>* getPredecessors() const {return &states_;}
+    virtual const std::vector<int>* getSuccessors() const {return &states_;}
+  private:
+    const std::vector<int>& states_;
+  };
+
   ros::NodeHandle nh_;
   ros::Subscriber goal_sub_, start_sub_, map_sub_;
   ros::Publisher path_pub_;
   boost::shared_ptr<SBPLPlanner> planner_;
   boost::shared_ptr<EnvironmentNAV2D> planner_environment_;
-  gridmap_2d::GridMap2DPtr map_;
+  boost::shared_ptr<GridPlanner2D> grid_planner_; ///< replaces SBPL for planner_type "GridPlanner2D"
+  /// grid of inflated_map_ for distanceMatrixService() with the SBPL planners
+  boost::shared_ptr<GridPlanner2D> distance_grid_;
+  unsigned long distance_grid_revision_; ///< revision of map_ in distance_grid_
+  size_t distance_field_cache_size_; ///< in bytes, for distanceMatrixService()
+  gridmap_2d::GridMap2DPtr map_; ///< patched in place by mapUpdateCallback() unless shared
+  unsigned long map_revision_; ///< revision of map_ for inflated_map_ and the environment
+  cv::Mat inflated_map_; ///< map_ inflated by robot_radius_ (shared, read-only)
 
   std::string planner_type_;
   double allocated_time_;
@@ -93,6 +147,11 @@ protected:
   bool search_until_first_solution_;
   bool forward_search_;
   double robot_radius_;
+  int distance_map_depth_; ///< CV_32F, CV_16U or CV_8U, set on maps passed to updateMap()
+  double distance_map_max_distance_; ///< saturation (in m) of a quantized distance map
+  bool smooth_path_; ///< publish shortcut and smoothed waypoints instead of all cells
+  double turning_radius_; ///< radius (in m) of the smoothed corners, 0 for none
+  PathSmoother2D path_smoother_;
 
   bool start_received_, goal_received_;
   geometry_msgs::Pose start_pose_, goal_pose_;
@@ -100,6 +159,8 @@ protected:
   double path_costs_;
   
   static const unsigned char OBSTACLE_COST = 20;
+  /// costs are updated incrementally if at most 1/INCREMENTAL_UPDATE_DIVISOR of the cells changed
+  static const unsigned int INCREMENTAL_UPDATE_DIVISOR = 4;
 
 };
 
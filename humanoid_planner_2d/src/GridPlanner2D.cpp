@@ -0,0 +1,475 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "humanoid_planner_2d/GridPlanner2D.h"
+
+#include <gridmap_2d/GridMap2D.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+
+namespace {
+/// octile distance (straight moves cost 1, diagonal ones sqrt(2))
+inline double octileDistance(int dx, int dy){
+  const int a = std::abs(dx);
+  const int b = std::abs(dy);
+  return (M_SQRT2 - 1.0) * std::min(a, b) + std::max(a, b);
+}
+
+inline int sign(int v){
+  return (v > 0) - (v < 0);
+}
+}
+
+void GridPlanner2D::SearchState::reset(size_t num_cells){
+  if (seen.size() != num_cells){
+    seen.assign(num_cells, 0);
+    closed.assign(num_cells, 0);
+    g.resize(num_cells);
+    parent.resize(num_cells);
+    generation = 0;
+  }
+
+  ++generation;
+  if (generation == 0){ // wrapped around
+    std::fill(seen.begin(), seen.end(), 0);
+    std::fill(closed.begin(), closed.end(), 0);
+    generation = 1;
+  }
+}
+
+GridPlanner2D::BatchPlanning::BatchPlanning(const GridPlanner2D& planner,
+                                            const std::vector<Query>& queries,
+                                            std::vector<Result>& results)
+: planner_(planner), queries_(queries), results_(results)
+{}
+
+void GridPlanner2D::BatchPlanning::operator()(const cv::Range& range) const{
+  SearchState state;
+  for (int i = range.start; i < range.end; ++i){
+    Result& result = results_[i];
+    result.success = planner_.search(state, queries_[i].start, queries_[i].goal, result.path, result.cost);
+  }
+}
+
+GridPlanner2D::DistanceFieldComputation::DistanceFieldComputation(const GridPlanner2D& planner,
+                                                                  const std::vector<int>& sources,
+                                                                  std::vector<DistanceFieldConstPtr>& fields)
+: planner_(planner), sources_(sources), fields_(fields)
+{}
+
+void GridPlanner2D::DistanceFieldComputation::operator()(const cv::Range& range) const{
+  for (int i = range.start; i < range.end; ++i){
+    boost::shared_ptr<DistanceField> field(new DistanceField());
+    planner_.computeDistanceField(sources_[i], *field);
+    fields_[i] = field;
+  }
+}
+
+GridPlanner2D::GridPlanner2D()
+: width_(0), height_(0), stride_(2),
+  distance_fields_bytes_(0),
+  distance_field_cache_size_(DEFAULT_DISTANCE_FIELD_CACHE_SIZE)
+{}
+
+GridPlanner2D::~GridPlanner2D(){
+
+}
+
+void GridPlanner2D::setMap(const cv::Mat& inflated_map){
+  width_ = inflated_map.rows;
+  height_ = inflated_map.cols;
+  stride_ = height_ + 2;
+
+  free_.assign((width_ + 2) * stride_, 0);
+  for (int mx = 0; mx < width_; ++mx){
+    const uchar* map_row = inflated_map.ptr<uchar>(mx);
+    unsigned char* free_row = &free_[index(mx, 0)];
+    for (int my = 0; my < height_; ++my)
+      free_row[my] = (map_row[my] != gridmap_2d::GridMap2D::OCCUPIED);
+  }
+
+  {
+    boost::mutex::scoped_lock lock(distance_fields_mutex_);
+    distance_fields_.clear();
+    distance_field_order_.clear();
+    distance_fields_bytes_ = 0;
+  }
+
+  // label connected free regions. Without cutting corners, every diagonal
+  // move can be replaced by two straight ones, so 4-connectivity suffices.
+  component_.assign(free_.size(), -1);
+  const int offsets[4] = {stride_, -stride_, 1, -1};
+  std::vector<int> queue;
+  int num_components = 0;
+  for (size_t start = 0; start < free_.size(); ++start){
+    if (!free_[start] || component_[start] >= 0)
+      continue;
+
+    component_[start] = num_components;
+    queue.assign(1, int(start));
+    while (!queue.empty()){
+      const int idx = queue.back();
+      queue.pop_back();
+      for (int i = 0; i < 4; ++i){
+        const int neighbor = idx + offsets[i];
+        if (free_[neighbor] && component_[neighbor] < 0){
+          component_[neighbor] = num_components;
+          queue.push_back(neighbor);
+        }
+      }
+    }
+    ++num_components;
+  }
+}
+
+bool GridPlanner2D::isReachable(const cv::Point& start, const cv::Point& goal) const{
+  if (!inGrid(start) || !inGrid(goal))
+    return false;
+
+  const int start_component = component_[index(start)];
+  return start_component >= 0 && start_component == component_[index(goal)];
+}
+
+bool GridPlanner2D::plan(const cv::Point& start, const cv::Point& goal,
+                         std::vector<cv::Point>& path, double& cost){
+  return search(state_, start, goal, path, cost);
+}
+
+void GridPlanner2D::planBatch(const std::vector<Query>& queries, std::vector<Result>& results) const{
+  results.assign(queries.size(), Result());
+  if (queries.empty())
+    return;
+
+  // a few stripes per thread, each with its own search data
+  const int num_stripes = std::min(int(queries.size()), 4 * std::max(cv::getNumThreads(), 1));
+  cv::parallel_for_(cv::Range(0, int(queries.size())),
+                    BatchPlanning(*this, queries, results), num_stripes);
+}
+
+void GridPlanner2D::distanceMatrix(const std::vector<cv::Point>& sources, const std::vector<cv::Point>& targets,
+                                   std::vector<double>& distances) const{
+  distances.assign(sources.size() * targets.size(), -1.0);
+
+  // cached distance fields are used right away, the missing ones are
+  // collected (each only once)
+  std::vector<int> missing_sources;
+  size_t cache_size;
+  {
+    boost::mutex::scoped_lock lock(distance_fields_mutex_);
+    cache_size = distance_field_cache_size_;
+    for (size_t i = 0; i < sources.size(); ++i){
+      if (!inGrid(sources[i]) || !isFree(index(sources[i])))
+        continue;
+
+      const int source = index(sources[i]);
+      std::map<int, DistanceFieldConstPtr>::const_iterator field_iter = distance_fields_.find(source);
+      if (field_iter != distance_fields_.end())
+        copyDistances(*field_iter->second, i, targets, distances);
+      else if (std::find(missing_sources.begin(), missing_sources.end(), source) == missing_sources.end())
+        missing_sources.push_back(source);
+    }
+  }
+  if (missing_sources.empty())
+    return;
+
+  // the missing fields are computed in parallel in batches that fit into
+  // the cache (at least one field each), every batch is consumed and
+  // cached before the next one is computed
+  const size_t batch_size = std::max(cache_size / (free_.size() * sizeof(float)), size_t(1));
+  for (size_t begin = 0; begin < missing_sources.size(); begin += batch_size){
+    const std::vector<int> batch(missing_sources.begin() + begin,
+                                 missing_sources.begin() + std::min(begin + batch_size, missing_sources.size()));
+    std::vector<DistanceFieldConstPtr> batch_fields(batch.size());
+    cv::parallel_for_(cv::Range(0, int(batch.size())), DistanceFieldComputation(*this, batch, batch_fields));
+
+    for (size_t i = 0; i < sources.size(); ++i){
+      if (!inGrid(sources[i]))
+        continue;
+      const std::vector<int>::const_iterator batch_iter = std::find(batch.begin(), batch.end(), index(sources[i]));
+      if (batch_iter != batch.end())
+        copyDistances(*batch_fields[batch_iter - batch.begin()], i, targets, distances);
+    }
+
+    boost::mutex::scoped_lock lock(distance_fields_mutex_);
+    for (size_t k = 0; k < batch.size(); ++k){
+      if (distance_fields_.insert(std::make_pair(batch[k], batch_fields[k])).second){
+        distance_field_order_.push_back(batch[k]);
+        distance_fields_bytes_ += batch_fields[k]->size() * sizeof(float);
+      }
+    }
+    evictDistanceFields();
+  }
+}
+
+void GridPlanner2D::copyDistances(const DistanceField& field, size_t source, const std::vector<cv::Point>& targets,
+                                  std::vector<double>& distances) const{
+  for (size_t j = 0; j < targets.size(); ++j){
+    if (inGrid(targets[j]) && field[index(targets[j])] < FLT_MAX)
+      distances[source * targets.size() + j] = field[index(targets[j])];
+  }
+}
+
+void GridPlanner2D::setDistanceFieldCacheSize(size_t max_bytes){
+  boost::mutex::scoped_lock lock(distance_fields_mutex_);
+  distance_field_cache_size_ = max_bytes;
+  evictDistanceFields();
+}
+
+void GridPlanner2D::evictDistanceFields() const{
+  while (distance_fields_bytes_ > distance_field_cache_size_ && !distance_field_order_.empty()){
+    const std::map<int, DistanceFieldConstPtr>::iterator field_iter =
+      distance_fields_.find(distance_field_order_.front());
+    distance_fields_bytes_ -= field_iter->second->size() * sizeof(float);
+    distance_fields_.erase(field_iter);
+    distance_field_order_.pop_front();
+  }
+}
+
+void GridPlanner2D::computeDistanceField(int source, DistanceField& field) const{
+  field.assign(free_.size(), FLT_MAX);
+
+  // 8-connected without cutting corners, as in search()
+  const int straight[4] = {stride_, -stride_, 1, -1};
+  const int diagonal[4][3] = {{stride_ + 1, stride_, 1}, {stride_ - 1, stride_, -1},
+                              {-stride_ + 1, -stride_, 1}, {-stride_ - 1, -stride_, -1}};
+  const float diagonal_cost = float(M_SQRT2);
+
+  typedef std::pair<float, int> OpenEntry;
+  std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry> > open;
+  field[source] = 0.0f;
+  open.push(OpenEntry(0.0f, source));
+  while (!open.empty()){
+    const float dist = open.top().first;
+    const int idx = open.top().second;
+    open.pop();
+    if (dist > field[idx])
+      continue; // outdated entry
+
+    for (int i = 0; i < 4; ++i){
+      const int neighbor = idx + straight[i];
+      if (free_[neighbor] && dist + 1.0f < field[neighbor]){
+        field[neighbor] = dist + 1.0f;
+        open.push(OpenEntry(field[neighbor], neighbor));
+      }
+    }
+    for (int i = 0; i < 4; ++i){
+      const int neighbor = idx + diagonal[i][0];
+      if (free_[neighbor] && free_[idx + diagonal[i][1]] && free_[idx + diagonal[i][2]]
+          && dist + diagonal_cost < field[neighbor]){
+        field[neighbor] = dist + diagonal_cost;
+        open.push(OpenEntry(field[neighbor], neighbor));
+      }
+    }
+  }
+}
+
+bool GridPlanner2D::search(SearchState& state, const cv::Point& start, const cv::Point& goal,
+                           std::vector<cv::Point>& path, double& cost) const{
+  path.clear();
+  cost = 0.0;
+  if (!isReachable(start, goal))
+    return false;
+
+  const int start_idx = index(start);
+  const int goal_idx = index(goal);
+
+  state.reset(free_.size());
+  const unsigned int generation = state.generation;
+
+  typedef std::pair<double, int> OpenEntry;
+  std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry> > open;
+  std::vector<cv::Point> directions;
+  directions.reserve(8);
+
+  state.seen[start_idx] = generation;
+  state.g[start_idx] = 0.0;
+  state.parent[start_idx] = -1;
+  open.push(OpenEntry(heuristic(start_idx, goal_idx), start_idx));
+
+  while (!open.empty()){
+    const int idx = open.top().second;
+    open.pop();
+    if (state.closed[idx] == generation)
+      continue; // outdated entry
+    state.closed[idx] = generation;
+
+    if (idx == goal_idx)
+      break;
+
+    const cv::Point idx_cell = cell(idx);
+    successorDirections(idx, state.parent[idx], directions);
+    for (size_t i = 0; i < directions.size(); ++i){
+      const int successor = jump(idx, directions[i].x, directions[i].y, goal_idx);
+      if (successor < 0 || state.closed[successor] == generation)
+        continue;
+
+      const cv::Point successor_cell = cell(successor);
+      const double g = state.g[idx]
+        + octileDistance(successor_cell.x - idx_cell.x, successor_cell.y - idx_cell.y);
+      if (state.seen[successor] != generation || g < state.g[successor]){
+        state.seen[successor] = generation;
+        state.g[successor] = g;
+        state.parent[successor] = idx;
+        open.push(OpenEntry(g + heuristic(successor, goal_idx), successor));
+      }
+    }
+  }
+
+  if (state.closed[goal_idx] != generation)
+    return false;
+
+  cost = state.g[goal_idx];
+
+  // jump points from goal to start, connected by straight or diagonal lines
+  std::vector<cv::Point> jump_points;
+  for (int idx = goal_idx; idx >= 0; idx = state.parent[idx])
+    jump_points.push_back(cell(idx));
+
+  path.push_back(jump_points.back());
+  for (size_t i = jump_points.size() - 1; i > 0; --i){
+    const cv::Point& to = jump_points[i - 1];
+    const cv::Point step(sign(to.x - jump_points[i].x), sign(to.y - jump_points[i].y));
+    while (path.back() != to)
+      path.push_back(path.back() + step);
+  }
+
+  return true;
+}
+
+int GridPlanner2D::jumpStraight(int idx, int dx, int dy, int goal) const{
+  const int step = dx * stride_ + dy;
+  // terminates at the occupied padding at the latest
+  while (true){
+    idx += step;
+    if (!isFree(idx))
+      return -1;
+    if (idx == goal)
+      return idx;
+
+    // forced neighbors: free cells beside the line, blocked behind it
+    if (dx != 0){
+      if ((isFree(idx, 0, 1) && !isFree(idx, -dx, 1))
+          || (isFree(idx, 0, -1) && !isFree(idx, -dx, -1)))
+        return idx;
+    } else {
+      if ((isFree(idx, 1, 0) && !isFree(idx, 1, -dy))
+          || (isFree(idx, -1, 0) && !isFree(idx, -1, -dy)))
+        return idx;
+    }
+  }
+}
+
+int GridPlanner2D::jump(int idx, int dx, int dy, int goal) const{
+  if (dx == 0 || dy == 0)
+    return jumpStraight(idx, dx, dy, goal);
+
+  const int step = dx * stride_ + dy;
+  while (true){
+    // no cutting of corners
+    if (!isFree(idx, dx, 0) || !isFree(idx, 0, dy))
+      return -1;
+    idx += step;
+    if (!isFree(idx))
+      return -1;
+    if (idx == goal)
+      return idx;
+
+    if (jumpStraight(idx, dx, 0, goal) >= 0 || jumpStraight(idx, 0, dy, goal) >= 0)
+      return idx;
+  }
+}
+
+void GridPlanner2D::successorDirections(int idx, int parent, std::vector<cv::Point>& directions) const{
+  directions.clear();
+
+  if (parent < 0){
+    for (int dx = -1; dx <= 1; ++dx){
+      for (int dy = -1; dy <= 1; ++dy){
+        if ((dx != 0 || dy != 0) && isFree(idx, dx, dy)
+            && (dx == 0 || dy == 0 || (isFree(idx, dx, 0) && isFree(idx, 0, dy))))
+          directions.push_back(cv::Point(dx, dy));
+      }
+    }
+    return;
+  }
+
+  const cv::Point from = cell(parent);
+  const cv::Point to = cell(idx);
+  const int dx = sign(to.x - from.x);
+  const int dy = sign(to.y - from.y);
+
+  if (dx != 0 && dy != 0){
+    const bool free_x = isFree(idx, dx, 0);
+    const bool free_y = isFree(idx, 0, dy);
+    if (free_y)
+      directions.push_back(cv::Point(0, dy));
+    if (free_x)
+      directions.push_back(cv::Point(dx, 0));
+    if (free_x && free_y)
+      directions.push_back(cv::Point(dx, dy));
+  } else if (dx != 0){
+    const bool free_up = isFree(idx, 0, 1);
+    const bool free_down = isFree(idx, 0, -1);
+    if (isFree(idx, dx, 0)){
+      directions.push_back(cv::Point(dx, 0));
+      if (free_up)
+        directions.push_back(cv::Point(dx, 1));
+      if (free_down)
+        directions.push_back(cv::Point(dx, -1));
+    }
+    if (free_up)
+      directions.push_back(cv::Point(0, 1));
+    if (free_down)
+      directions.push_back(cv::Point(0, -1));
+  } else {
+    const bool free_right = isFree(idx, 1, 0);
+    const bool free_left = isFree(idx, -1, 0);
+    if (isFree(idx, 0, dy)){
+      directions.push_back(cv::Point(0, dy));
+      if (free_right)
+        directions.push_back(cv::Point(1, dy));
+      if (free_left)
+        directions.push_back(cv::Point(-1, dy));
+    }
+    if (free_right)
+      directions.push_back(cv::Point(1, 0));
+    if (free_left)
+      directions.push_back(cv::Point(-1, 0));
+  }
+}
+
+double GridPlanner2D::heuristic(int idx, int goal) const{
+  const cv::Point from = cell(idx);
+  const cv::Point to = cell(goal);
+  return octileDistance(to.x - from.x, to.y - from.y);
+}
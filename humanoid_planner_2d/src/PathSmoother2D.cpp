@@ -0,0 +1,209 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "humanoid_planner_2d/PathSmoother2D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+const double PathSmoother2D::MAX_ARC_STEP = M_PI / 12.0;
+
+PathSmoother2D::PathSmoother2D()
+: turning_radius_(0.0)
+{}
+
+PathSmoother2D::~PathSmoother2D(){
+
+}
+
+void PathSmoother2D::setMap(const cv::Mat& inflated_map){
+  inflated_map_ = inflated_map;
+}
+
+void PathSmoother2D::process(const std::vector<cv::Point>& cells, std::vector<cv::Point2d>& waypoints) const{
+  shortcut(cells, waypoints);
+  smooth(waypoints);
+}
+
+void PathSmoother2D::shortcut(const std::vector<cv::Point>& cells, std::vector<cv::Point2d>& waypoints) const{
+  waypoints.clear();
+  if (cells.empty())
+    return;
+
+  // greedy: extend the line from the last waypoint as long as it is free
+  const cv::Point2d center(0.5, 0.5);
+  cv::Point2d anchor = cv::Point2d(cells.front()) + center;
+  waypoints.push_back(anchor);
+  for (size_t i = 1; i + 1 < cells.size(); ++i){
+    if (!lineOfSight(anchor, cv::Point2d(cells[i + 1]) + center)){
+      anchor = cv::Point2d(cells[i]) + center;
+      waypoints.push_back(anchor);
+    }
+  }
+  if (cells.size() > 1)
+    waypoints.push_back(cv::Point2d(cells.back()) + center);
+}
+
+void PathSmoother2D::smooth(std::vector<cv::Point2d>& waypoints) const{
+  if (turning_radius_ <= 0.0 || waypoints.size() < 3)
+    return;
+
+  std::vector<cv::Point2d> smoothed;
+  smoothed.reserve(waypoints.size());
+  smoothed.push_back(waypoints.front());
+  // length of the segment to waypoints[i] already used by the previous arc
+  double used_length = 0.0;
+  for (size_t i = 1; i + 1 < waypoints.size(); ++i){
+    const cv::Point2d& corner = waypoints[i];
+    const cv::Point2d to_prev = waypoints[i - 1] - corner;
+    const cv::Point2d to_next = waypoints[i + 1] - corner;
+    const double prev_length = std::sqrt(to_prev.dot(to_prev));
+    const double next_length = std::sqrt(to_next.dot(to_next));
+    if (prev_length <= 0.0 || next_length <= 0.0){
+      used_length = 0.0;
+      continue; // duplicate waypoint
+    }
+
+    const cv::Point2d u = to_prev * (1.0 / prev_length);
+    const cv::Point2d v = to_next * (1.0 / next_length);
+    // interior angle at the corner, nearly straight or reversing paths stay as they are
+    const double angle = std::acos(std::max(-1.0, std::min(1.0, u.dot(v))));
+    if (angle > M_PI - 1e-3 || angle < 1e-3){
+      smoothed.push_back(corner);
+      used_length = 0.0;
+      continue;
+    }
+
+    // the arc touches both segments at 'tangent' from the corner. It has to
+    // fit into the rest of the previous segment and into the next one (only
+    // half of it unless it is the last one, the other half is left to the
+    // next arc), otherwise the corner is kept: a smaller radius would not be
+    // drivable.
+    const double tan_half = std::tan(angle / 2.0);
+    const double tangent = turning_radius_ / tan_half;
+    const double next_available = (i + 2 == waypoints.size()) ? next_length : 0.5 * next_length;
+    if (tangent > prev_length - used_length || tangent > next_available){
+      smoothed.push_back(corner);
+      used_length = 0.0;
+      continue;
+    }
+    const double radius = turning_radius_;
+    cv::Point2d bisector = u + v;
+    bisector *= 1.0 / std::sqrt(bisector.dot(bisector));
+    const cv::Point2d arc_center = corner + bisector * (radius / std::sin(angle / 2.0));
+    const cv::Point2d arc_start = corner + u * tangent;
+    const cv::Point2d arc_end = corner + v * tangent;
+
+    const double start_angle = std::atan2(arc_start.y - arc_center.y, arc_start.x - arc_center.x);
+    double sweep = std::atan2(arc_end.y - arc_center.y, arc_end.x - arc_center.x) - start_angle;
+    if (sweep > M_PI)
+      sweep -= 2.0 * M_PI;
+    else if (sweep < -M_PI)
+      sweep += 2.0 * M_PI;
+
+    const int num_steps = std::max(1, int(std::ceil(std::abs(sweep) / MAX_ARC_STEP)));
+    std::vector<cv::Point2d> arc(1, arc_start);
+    for (int step = 1; step < num_steps; ++step){
+      const double a = start_angle + sweep * step / num_steps;
+      arc.push_back(arc_center + cv::Point2d(std::cos(a), std::sin(a)) * radius);
+    }
+    arc.push_back(arc_end);
+
+    // the arc ends lie on the free segments, the samples in between need checks
+    bool free = true;
+    for (size_t j = 1; j < arc.size() && free; ++j)
+      free = lineOfSight(arc[j - 1], arc[j]);
+
+    if (free){
+      smoothed.insert(smoothed.end(), arc.begin(), arc.end());
+      used_length = tangent;
+    } else {
+      smoothed.push_back(corner);
+      used_length = 0.0;
+    }
+  }
+  smoothed.push_back(waypoints.back());
+
+  waypoints.swap(smoothed);
+}
+
+bool PathSmoother2D::lineOfSight(const cv::Point2d& from, const cv::Point2d& to) const{
+  int mx = int(std::floor(from.x));
+  int my = int(std::floor(from.y));
+  const int end_mx = int(std::floor(to.x));
+  const int end_my = int(std::floor(to.y));
+  if (!isFree(mx, my))
+    return false;
+
+  // traverse all cells along the line (Amanatides & Woo)
+  const double inf = std::numeric_limits<double>::infinity();
+  const double dx = to.x - from.x;
+  const double dy = to.y - from.y;
+  const int step_x = (dx > 0.0) - (dx < 0.0);
+  const int step_y = (dy > 0.0) - (dy < 0.0);
+  const double delta_x = step_x ? 1.0 / std::abs(dx) : inf;
+  const double delta_y = step_y ? 1.0 / std::abs(dy) : inf;
+  double next_x = step_x ? (step_x > 0 ? mx + 1 - from.x : from.x - mx) * delta_x : inf;
+  double next_y = step_y ? (step_y > 0 ? my + 1 - from.y : from.y - my) * delta_y : inf;
+
+  int num_steps = std::abs(end_mx - mx) + std::abs(end_my - my);
+  while ((mx != end_mx || my != end_my) && num_steps-- > 0){
+    if (std::abs(next_x - next_y) < 1e-9){
+      // exactly through a corner: no cutting past occupied cells
+      if (!isFree(mx + step_x, my) || !isFree(mx, my + step_y))
+        return false;
+      mx += step_x;
+      my += step_y;
+      next_x += delta_x;
+      next_y += delta_y;
+      --num_steps;
+    } else if (next_x < next_y){
+      mx += step_x;
+      next_x += delta_x;
+    } else {
+      my += step_y;
+      next_y += delta_y;
+    }
+
+    if (!isFree(mx, my))
+      return false;
+  }
+
+  return true;
+}
+
+double PathSmoother2D::length(const std::vector<cv::Point2d>& waypoints){
+  double length = 0.0;
+  for (size_t i = 1; i < waypoints.size(); ++i){
+    const cv::Point2d d = waypoints[i] - waypoints[i - 1];
+    length += std::sqrt(d.dot(d));
+  }
+  return length;
+}
@@ -28,9 +28,16 @@
 
 #include "humanoid_planner_2d/SBPLPlanner2D.h"
 
+#include <algorithm>
+
 SBPLPlanner2D::SBPLPlanner2D()
   : nh_(),
+  distance_grid_revision_(0),
+  distance_field_cache_size_(GridPlanner2D::DEFAULT_DISTANCE_FIELD_CACHE_SIZE),
+  map_revision_(0),
   robot_radius_(0.25),
+  distance_map_depth_(CV_32F),
+  distance_map_max_distance_(0.0),
   start_received_(false), goal_received_(false),
   path_costs_(0.0)
 {
@@ -43,6 +50,34 @@ SBPLPlanner2D::SBPLPlanner2D()
   nh_private.param("forward_search", forward_search_, false);
   nh_private.param("initial_epsilon", initial_epsilon_, 3.0);
   nh_private.param("robot_radius", robot_radius_, robot_radius_);
+  nh_private.param("smooth_path", smooth_path_, false);
+  nh_private.param("turning_radius", turning_radius_, 0.0);
+  int distance_field_cache_size; // in MiB
+  nh_private.param("distance_field_cache_size", distance_field_cache_size,
+                   int(GridPlanner2D::DEFAULT_DISTANCE_FIELD_CACHE_SIZE >> 20));
+  distance_field_cache_size_ = size_t(std::max(distance_field_cache_size, 0)) << 20;
+  // distance maps stored with 32 (float), 16 or 8 bits per cell, see
+  // gridmap_2d::GridMap2D::setDistanceMapDepth()
+  int distance_map_depth;
+  nh_private.param("distance_map_depth", distance_map_depth, 32);
+  nh_private.param("distance_map_max_distance", distance_map_max_distance_, 1.0);
+  if (distance_map_depth == 16)
+    distance_map_depth_ = CV_16U;
+  else if (distance_map_depth == 8)
+    distance_map_depth_ = CV_8U;
+  else if (distance_map_depth != 32)
+    ROS_ERROR("distance_map_depth %d not supported (32, 16 or 8), using 32", distance_map_depth);
+  // distances saturate at the maximum, it must exceed the inflation radius
+  if (distance_map_depth_ != CV_32F && distance_map_max_distance_ <= robot_radius_){
+    ROS_ERROR("distance_map_max_distance %f must be larger than robot_radius %f, using a 32 bit distance map",
+              distance_map_max_distance_, robot_radius_);
+    distance_map_depth_ = CV_32F;
+  }
+
+  if (planner_type_ == "GridPlanner2D"){
+    grid_planner_.reset(new GridPlanner2D());
+    grid_planner_->setDistanceFieldCacheSize(distance_field_cache_size_);
+  }
 
   path_pub_ = nh_.advertise<nav_msgs::Path>("path", 0);
 
@@ -124,64 +159,92 @@ bool SBPLPlanner2D::plan(){
     return false;
   }
 
-  if (map_->isOccupiedAtCell(start_x, start_y)){
+  if (inflated_map_.at<uchar>(start_x, start_y) == gridmap_2d::GridMap2D::OCCUPIED){
     ROS_ERROR("Start coordinate (%f %f) is occupied in map", start_pose_.position.x, start_pose_.position.y);
     return false;
   }
-  if (map_->isOccupiedAtCell(goal_x, goal_y)){
+  if (inflated_map_.at<uchar>(goal_x, goal_y) == gridmap_2d::GridMap2D::OCCUPIED){
     ROS_ERROR("Goal coordinate (%f %f) is occupied in map", goal_pose_.position.x, goal_pose_.position.y);
     return false;
   }
 
-  int start_id = planner_environment_->SetStart(start_x, start_y);
-  int goal_id = planner_environment_->SetGoal(goal_x, goal_y);
+  std::vector<cv::Point> path_cells;
+  if (grid_planner_){
+    double cost;
+    if (!grid_planner_->plan(cv::Point(start_x, start_y), cv::Point(goal_x, goal_y), path_cells, cost)){
+      ROS_INFO("Solution not found");
+      return false;
+    }
+    ROS_DEBUG("Solution found. Costs: %f cells", cost);
+    path_costs_ = cost * map_->getResolution();
+  } else {
+    int start_id = planner_environment_->SetStart(start_x, start_y);
+    int goal_id = planner_environment_->SetGoal(goal_x, goal_y);
+
+    if (start_id < 0 || planner_->set_start(start_id) == 0){
+      ROS_ERROR("Failed to set start state");
+      return false;
+    }
 
-  if (start_id < 0 || planner_->set_start(start_id) == 0){
-    ROS_ERROR("Failed to set start state");
-    return false;
-  }
+    if (goal_id < 0 || planner_->set_goal(goal_id) == 0){
+      ROS_ERROR("Failed to set goal state");
+      return false;
+    }
 
-  if (goal_id < 0 || planner_->set_goal(goal_id) == 0){
-    ROS_ERROR("Failed to set goal state");
-    return false;
-  }
+    // set planner params:
+    planner_->set_initialsolution_eps(initial_epsilon_);
+    planner_->set_search_mode(search_until_first_solution_);
+    std::vector<int> solution_stateIDs;
+    int solution_cost;
 
-  // set planner params:
-  planner_->set_initialsolution_eps(initial_epsilon_);
-  planner_->set_search_mode(search_until_first_solution_);
-  std::vector<int> solution_stateIDs;
-  int solution_cost;
 
+    if(planner_->replan(allocated_time_, &solution_stateIDs, &solution_cost))
+      ROS_DEBUG("Solution found. Costs: %d;  final eps: %f", solution_cost, planner_->get_final_epsilon());
+    else{
+      ROS_INFO("Solution not found");
+      return false;
+    }
 
-  if(planner_->replan(allocated_time_, &solution_stateIDs, &solution_cost))
-    ROS_DEBUG("Solution found. Costs: %d;  final eps: %f", solution_cost, planner_->get_final_epsilon());
-  else{
-    ROS_INFO("Solution not found");
-    return false;
-  }
+    // scale costs (SBPL uses mm and does not know map res)
+    path_costs_ = double(solution_cost) / ENVNAV2D_COSTMULT * map_->getResolution();
 
-  // scale costs (SBPL uses mm and does not know map res)
-  path_costs_ = double(solution_cost) / ENVNAV2D_COSTMULT * map_->getResolution();
+    path_cells.resize(solution_stateIDs.size());
+    for (size_t i = 0; i < solution_stateIDs.size(); i++)
+      planner_environment_->GetCoordFromState(solution_stateIDs[i], path_cells[i].x, path_cells[i].y);
+  }
 
   // extract / publish path:
-  path_.poses.reserve(solution_stateIDs.size());
   path_.header.frame_id = map_->getFrameID();
   path_.header.stamp = ros::Time::now();
 
   geometry_msgs::PoseStamped pose;
   pose.header = path_.header;
-  for (size_t i = 0; i < solution_stateIDs.size(); i++) {
-    int mx, my;
-    planner_environment_->GetCoordFromState(solution_stateIDs[i], mx, my);
-    //ROS_INFO("p: %d - [%d %d]", solution_stateIDs[i], mx, my);
-    double wx,wy;
-    map_->mapToWorld(mx,my,wx,wy);
+  if (smooth_path_){
+    // few waypoints along the free shortcuts (in cells, see PathSmoother2D)
+    std::vector<cv::Point2d> waypoints;
+    path_smoother_.process(path_cells, waypoints);
+    path_costs_ = PathSmoother2D::length(waypoints) * map_->getResolution();
+    ROS_DEBUG("Path of %d cells smoothed to %d waypoints", (int)path_cells.size(), (int)waypoints.size());
+
+    path_.poses.reserve(waypoints.size());
+    for (size_t i = 0; i < waypoints.size(); i++) {
+      pose.pose.position.x = map_->getInfo().origin.position.x + waypoints[i].x * map_->getResolution();
+      pose.pose.position.y = map_->getInfo().origin.position.y + waypoints[i].y * map_->getResolution();
+      pose.pose.position.z = 0.0;
+      path_.poses.push_back(pose);
+    }
+  } else {
+    path_.poses.reserve(path_cells.size());
+    for (size_t i = 0; i < path_cells.size(); i++) {
+      double wx,wy;
+      map_->mapToWorld(path_cells[i].x, path_cells[i].y, wx, wy);
 
 
-    pose.pose.position.x = wx;
-    pose.pose.position.y = wy;
-    pose.pose.position.z = 0.0;
-    path_.poses.push_back(pose);
+      pose.pose.position.x = wx;
+      pose.pose.position.y = wy;
+      pose.pose.position.z = 0.0;
+      path_.poses.push_back(pose);
+    }
   }
 
   path_pub_.publish(path_);
@@ -189,33 +252,182 @@ bool SBPLPlanner2D::plan(){
   return true;
 }
 
+bool SBPLPlanner2D::distanceMatrixService(humanoid_planner_2d::DistanceMatrix::Request& req,
+                                          humanoid_planner_2d::DistanceMatrix::Response& resp){
+  if (!map_){
+    ROS_ERROR("Map not set");
+    return false;
+  }
+
+  const GridPlanner2D* grid = grid_planner_.get();
+  if (!grid){
+    if (!distance_grid_ || distance_grid_revision_ != map_->getRevision()){
+      if (!distance_grid_){
+        distance_grid_.reset(new GridPlanner2D());
+        distance_grid_->setDistanceFieldCacheSize(distance_field_cache_size_);
+      }
+      distance_grid_->setMap(inflated_map_);
+      distance_grid_revision_ = map_->getRevision();
+    }
+    grid = distance_grid_.get();
+  }
+
+  // points outside of the map are passed on as (-1, -1) and never reached
+  std::vector<cv::Point> sources(req.sources.size(), cv::Point(-1, -1));
+  std::vector<cv::Point> targets(req.targets.size(), cv::Point(-1, -1));
+  unsigned int mx, my;
+  for (size_t i = 0; i < req.sources.size(); ++i){
+    if (map_->worldToMap(req.sources[i].x, req.sources[i].y, mx, my))
+      sources[i] = cv::Point(mx, my);
+  }
+  for (size_t j = 0; j < req.targets.size(); ++j){
+    if (map_->worldToMap(req.targets[j].x, req.targets[j].y, mx, my))
+      targets[j] = cv::Point(mx, my);
+  }
+
+  grid->distanceMatrix(sources, targets, resp.distances);
+  for (size_t i = 0; i < resp.distances.size(); ++i){
+    if (resp.distances[i] >= 0.0)
+      resp.distances[i] *= map_->getResolution();
+  }
+
+  return true;
+}
+
 void SBPLPlanner2D::mapCallback(const nav_msgs::OccupancyGridConstPtr& occupancy_map){
-  gridmap_2d::GridMap2DPtr map(new gridmap_2d::GridMap2D(occupancy_map));
+  // as successor of the current map, its changes are known to updateEnvironment()
+  gridmap_2d::GridMap2DPtr map;
+  if (map_)
+    map.reset(new gridmap_2d::GridMap2D(occupancy_map, *map_));
+  else
+    map.reset(new gridmap_2d::GridMap2D(occupancy_map));
   updateMap(map);
 }
 
+void SBPLPlanner2D::mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& map_update){
+  if (!map_){
+    ROS_WARN("Map update received before the map, ignoring it.");
+    return;
+  }
+
+  // copy-on-write: map_ is patched in place unless it is also used
+  // elsewhere (getMap() or a map passed to updateMap())
+  if (!map_.unique())
+    map_.reset(new gridmap_2d::GridMap2D(*map_));
+  if (map_->applyUpdate(map_update))
+    updateMap(map_);
+}
+
 bool SBPLPlanner2D::updateMap(gridmap_2d::GridMap2DPtr map){
+  // successors of the map (see mapCallback()) keep the depth, i.e. it is
+  // only converted once. The rounded distances may inflate a few more cells
+  // without a new revision, so the planner is set up from scratch then.
+  const bool converted = map->getDistanceMapDepth() != distance_map_depth_;
+  if (converted){
+    map->setDistanceMapDepth(distance_map_depth_, distance_map_max_distance_);
+    distance_grid_.reset();
+  }
+
+  // the inflated map is thresholded from the distance map of 'map' and
+  // shared with all other users of the same radius
+  const cv::Mat inflated_map = map->inflatedBinaryMap(robot_radius_);
+
+  if (grid_planner_){
+    // the grid and its distance fields are kept for the same map revision
+    if (!map_ || converted || map_revision_ != map->getRevision())
+      grid_planner_->setMap(inflated_map);
+  } else if (!planner_environment_ || !map_ || converted
+      || map_->getInfo().width != map->getInfo().width
+      || map_->getInfo().height != map->getInfo().height
+      || !updateEnvironment(map, inflated_map))
+  {
+    initializeEnvironment(inflated_map);
+  }
+
+  map_ = map;
+  map_revision_ = map_->getRevision();
+  inflated_map_ = inflated_map;
+  path_smoother_.setMap(inflated_map_);
+  path_smoother_.setTurningRadius(turning_radius_ / map_->getResolution());
+
+  ROS_DEBUG("Map set");
+
+  return true;
+}
+
+void SBPLPlanner2D::initializeEnvironment(const cv::Mat& inflated_map){
+  // costs in SBPL's layout (x + y * width), i.e. transposed to the map:
+  cv::Mat costs, env_costs;
+  cv::threshold(inflated_map, costs, gridmap_2d::GridMap2D::OCCUPIED, OBSTACLE_COST, cv::THRESH_BINARY_INV);
+  cv::transpose(costs, env_costs);
+
   planner_environment_.reset(new EnvironmentNAV2D());
-  planner_environment_->InitializeEnv(int(map->getInfo().width), int(map->getInfo().height), 0, OBSTACLE_COST);
+  planner_environment_->InitializeEnv(env_costs.cols, env_costs.rows, env_costs.ptr<unsigned char>(0), OBSTACLE_COST);
   // environment is set up, reset planner:
   setPlanner();
+}
 
-  // store local copy:
-  map_.reset(new gridmap_2d::GridMap2D(*map));
-  map_->inflateMap(robot_radius_);
-
+bool SBPLPlanner2D::updateEnvironment(const gridmap_2d::GridMap2DPtr& map, const cv::Mat& inflated_map){
+  const cv::Rect map_cells(0, 0, map->getInfo().width, map->getInfo().height);
+  std::vector<cv::Rect> changed_regions;
+  if (!map->getChangesSince(map_revision_, changed_regions)){
+    changed_regions.clear();
+    changed_regions.push_back(map_cells);
+  }
 
-  for(unsigned int j = 0; j < map_->getInfo().height; ++j){
-    for(unsigned int i = 0; i < map_->getInfo().width; ++i){
-      if (map_->isOccupiedAtCell(i,j))
-        planner_environment_->UpdateCost(i, j, OBSTACLE_COST);
-      else
-        planner_environment_->UpdateCost(i,j,0);
+  // inflated obstacles change up to the robot radius around changes
+  // (regions: x = mx, y = my, i.e. rows and columns are swapped in the cv::Mat)
+  const int border = int(ceil(robot_radius_ / map->getResolution())) + 1;
+  std::vector<nav2dcell_t> changed_cells;
+  cv::Mat changed(inflated_map.size(), CV_8UC1, cv::Scalar(0));
+  cv::Rect changed_bounds;
+  for (size_t i = 0; i < changed_regions.size(); ++i){
+    const cv::Rect& r = changed_regions[i];
+    const cv::Rect region = cv::Rect(r.x - border, r.y - border, r.width + 2 * border, r.height + 2 * border) & map_cells;
+    if (region.area() == 0)
+      continue;
+
+    const cv::Rect roi(region.y, region.x, region.height, region.width);
+    cv::Mat changed_roi = changed(roi);
+    cv::compare(inflated_map(roi), inflated_map_(roi), changed_roi, cv::CMP_NE);
+    changed_bounds = changed_bounds.area() ? (changed_bounds | roi) : roi;
+  }
 
+  for (int mx = changed_bounds.y; mx < changed_bounds.y + changed_bounds.height; ++mx){
+    const uchar* changed_row = changed.ptr<uchar>(mx);
+    for (int my = changed_bounds.x; my < changed_bounds.x + changed_bounds.width; ++my){
+      if (changed_row[my]){
+        nav2dcell_t cell;
+        cell.x = mx;
+        cell.y = my;
+        changed_cells.push_back(cell);
+      }
     }
   }
 
-  ROS_DEBUG("Map set");
+  if (changed_cells.size() * INCREMENTAL_UPDATE_DIVISOR > size_t(map_cells.area()))
+    return false;
+
+  if (changed_cells.empty())
+    return true;
+
+  for (size_t i = 0; i < changed_cells.size(); ++i){
+    const nav2dcell_t& cell = changed_cells[i];
+    if (inflated_map.at<uchar>(cell.x, cell.y) == gridmap_2d::GridMap2D::OCCUPIED)
+      planner_environment_->UpdateCost(cell.x, cell.y, OBSTACLE_COST);
+    else
+      planner_environment_->UpdateCost(cell.x, cell.y, 0);
+  }
+
+  // let the planner repair its search (ADPlanner) or restart it (others)
+  std::vector<int> changed_states;
+  if (forward_search_)
+    planner_environment_->GetSuccsofChangedEdges(&changed_cells, &changed_states);
+  else
+    planner_environment_->GetPredsofChangedEdges(&changed_cells, &changed_states);
+  planner_->costs_changed(ChangedStatesQuery(changed_states));
+
+  ROS_DEBUG("Updated the costs of %d cells", (int)changed_cells.size());
 
   return true;
 }
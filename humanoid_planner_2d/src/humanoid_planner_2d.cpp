@@ -35,8 +35,10 @@ public:
     ros::NodeHandle nh;
 
     map_sub_ = nh.subscribe<nav_msgs::OccupancyGrid>("map", 1, &SBPLPlanner2D::mapCallback, &planner_);
+    map_update_sub_ = nh.subscribe<map_msgs::OccupancyGridUpdate>("map_updates", 10, &SBPLPlanner2D::mapUpdateCallback, &planner_);
     goal_sub_ = nh.subscribe<geometry_msgs::PoseStamped>("goal", 1, &SBPLPlanner2D::goalCallback, &planner_);
     start_sub_ = nh.subscribe<geometry_msgs::PoseWithCovarianceStamped>("initialpose", 1, &SBPLPlanner2D::startCallback, &planner_);
+    distance_matrix_srv_ = nh.advertiseService("distance_matrix", &SBPLPlanner2D::distanceMatrixService, &planner_);
 
   }
 
@@ -44,7 +46,8 @@ public:
 
 protected:
   SBPLPlanner2D planner_;
-  ros::Subscriber map_sub_, goal_sub_, start_sub_;
+  ros::Subscriber map_sub_, map_update_sub_, goal_sub_, start_sub_;
+  ros::ServiceServer distance_matrix_srv_;
 
 
 };
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the planner types of SBPLPlanner2D on random start / goal
+ * queries in the map received on "map", e.g. one of the bundled maps of
+ * footstep_planner (see launch/planner_2d_benchmark.launch).
+ */
+
+#include <ros/ros.h>
+#include <ros/topic.h>
+#include <humanoid_planner_2d/SBPLPlanner2D.h>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+
+int main(int argc, char** argv){
+  ros::init(argc, argv, "planner_2d_benchmark");
+  ros::NodeHandle nh;
+  ros::NodeHandle nh_private("~");
+
+  std::string planner_types;
+  int num_queries, random_seed;
+  nh_private.param("planner_types", planner_types, std::string("GridPlanner2D ARAPlanner ADPlanner"));
+  nh_private.param("num_queries", num_queries, 100);
+  nh_private.param("random_seed", random_seed, 0);
+
+  ROS_INFO("Waiting for map...");
+  nav_msgs::OccupancyGridConstPtr occupancy_map =
+    ros::topic::waitForMessage<nav_msgs::OccupancyGrid>("map", nh);
+  if (!occupancy_map)
+    return 1;
+  gridmap_2d::GridMap2DPtr map(new gridmap_2d::GridMap2D(occupancy_map));
+
+  // random queries between free cells of the inflated map, also unreachable ones
+  double robot_radius = 0.25;
+  nh_private.param("robot_radius", robot_radius, robot_radius);
+  const cv::Mat inflated_map = map->inflatedBinaryMap(robot_radius);
+  std::vector<cv::Point> free_cells;
+  for (int mx = 0; mx < inflated_map.rows; ++mx){
+    for (int my = 0; my < inflated_map.cols; ++my){
+      if (inflated_map.at<uchar>(mx, my) != gridmap_2d::GridMap2D::OCCUPIED)
+        free_cells.push_back(cv::Point(mx, my));
+    }
+  }
+  if (free_cells.empty()){
+    ROS_ERROR("No free cells in the map");
+    return 1;
+  }
+
+  boost::mt19937 rng(random_seed);
+  boost::variate_generator<boost::mt19937&, boost::uniform_int<size_t> >
+    random_cell(rng, boost::uniform_int<size_t>(0, free_cells.size() - 1));
+  std::vector<GridPlanner2D::Query> queries(num_queries);
+  for (int i = 0; i < num_queries; ++i){
+    queries[i].start = free_cells[random_cell()];
+    queries[i].goal = free_cells[random_cell()];
+  }
+
+  ROS_INFO("Map with %d x %d cells, %d queries", map->getInfo().width, map->getInfo().height, num_queries);
+
+  std::istringstream types(planner_types);
+  std::string planner_type;
+  while (types >> planner_type && ros::ok()){
+    // SBPLPlanner2D reads its parameters from this node's namespace
+    nh_private.setParam("planner_type", planner_type);
+    SBPLPlanner2D planner;
+
+    ros::WallTime start_time = ros::WallTime::now();
+    planner.updateMap(map);
+    const double map_time = (ros::WallTime::now() - start_time).toSec();
+
+    int num_solved = 0;
+    double total_time = 0.0, max_time = 0.0, total_costs = 0.0;
+    for (int i = 0; i < num_queries && ros::ok(); ++i){
+      double start_x, start_y, goal_x, goal_y;
+      map->mapToWorld(queries[i].start.x, queries[i].start.y, start_x, start_y);
+      map->mapToWorld(queries[i].goal.x, queries[i].goal.y, goal_x, goal_y);
+
+      start_time = ros::WallTime::now();
+      const bool solved = planner.plan(start_x, start_y, goal_x, goal_y);
+      const double time = (ros::WallTime::now() - start_time).toSec();
+      total_time += time;
+      max_time = std::max(max_time, time);
+      if (solved){
+        ++num_solved;
+        total_costs += planner.getPathCosts();
+      }
+    }
+
+    ROS_INFO("%s: map setup %f s, %d / %d solved, query time mean %f s, max %f s, mean path costs %f m",
+             planner_type.c_str(), map_time, num_solved, num_queries,
+             total_time / std::max(num_queries, 1), max_time,
+             total_costs / std::max(num_solved, 1));
+
+    if (planner.getGridPlanner()){
+      std::vector<GridPlanner2D::Result> results;
+      start_time = ros::WallTime::now();
+      planner.getGridPlanner()->planBatch(queries, results);
+      const double batch_time = (ros::WallTime::now() - start_time).toSec();
+      ROS_INFO("%s: batch of %d queries in %f s with %d threads", planner_type.c_str(),
+               num_queries, batch_time, cv::getNumThreads());
+    }
+  }
+
+  return 0;
+}
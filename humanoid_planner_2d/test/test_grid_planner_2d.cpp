@@ -0,0 +1,325 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <humanoid_planner_2d/GridPlanner2D.h>
+#include <gridmap_2d/GridMap2D.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+
+namespace {
+const uchar FREE = gridmap_2d::GridMap2D::FREE;
+const uchar OCCUPIED = gridmap_2d::GridMap2D::OCCUPIED;
+
+/// inflated map (rows: mx, cols: my) with randomly occupied cells
+cv::Mat randomMap(int width, int height, double occupied_ratio, unsigned int seed){
+  srand(seed);
+  cv::Mat map(width, height, CV_8UC1, cv::Scalar(FREE));
+  for (int mx = 0; mx < width; ++mx){
+    for (int my = 0; my < height; ++my){
+      if (rand() < occupied_ratio * RAND_MAX)
+        map.at<uchar>(mx, my) = OCCUPIED;
+    }
+  }
+  return map;
+}
+
+bool isFree(const cv::Mat& map, int mx, int my){
+  return mx >= 0 && my >= 0 && mx < map.rows && my < map.cols && map.at<uchar>(mx, my) != OCCUPIED;
+}
+
+/// plain 8-connected Dijkstra without cutting corners, costs of all cells from start (-1: unreachable)
+std::vector<double> dijkstra(const cv::Mat& map, const cv::Point& start){
+  std::vector<double> dist(map.rows * map.cols, DBL_MAX);
+  typedef std::pair<double, int> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+  dist[start.x * map.cols + start.y] = 0.0;
+  open.push(Entry(0.0, start.x * map.cols + start.y));
+  while (!open.empty()){
+    const double d = open.top().first;
+    const int mx = open.top().second / map.cols;
+    const int my = open.top().second % map.cols;
+    open.pop();
+    if (d > dist[mx * map.cols + my])
+      continue;
+
+    for (int dx = -1; dx <= 1; ++dx){
+      for (int dy = -1; dy <= 1; ++dy){
+        if ((dx == 0 && dy == 0) || !isFree(map, mx + dx, my + dy))
+          continue;
+        if (dx != 0 && dy != 0 && (!isFree(map, mx + dx, my) || !isFree(map, mx, my + dy)))
+          continue;
+        const double cost = d + ((dx != 0 && dy != 0) ? M_SQRT2 : 1.0);
+        double& neighbor_dist = dist[(mx + dx) * map.cols + my + dy];
+        if (cost < neighbor_dist){
+          neighbor_dist = cost;
+          open.push(Entry(cost, (mx + dx) * map.cols + my + dy));
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < dist.size(); ++i){
+    if (dist[i] == DBL_MAX)
+      dist[i] = -1.0;
+  }
+  return dist;
+}
+
+cv::Point randomFreeCell(const cv::Mat& map){
+  while (true){
+    const cv::Point cell(rand() % map.rows, rand() % map.cols);
+    if (isFree(map, cell.x, cell.y))
+      return cell;
+  }
+}
+
+/// checks that the path is a connected sequence of free cells from start to goal with the given cost
+void checkPath(const cv::Mat& map, const cv::Point& start, const cv::Point& goal,
+               const std::vector<cv::Point>& path, double cost){
+  ASSERT_FALSE(path.empty());
+  EXPECT_EQ(start, path.front());
+  EXPECT_EQ(goal, path.back());
+  double path_cost = 0.0;
+  for (size_t i = 0; i < path.size(); ++i){
+    ASSERT_TRUE(isFree(map, path[i].x, path[i].y));
+    if (i == 0)
+      continue;
+
+    const int dx = path[i].x - path[i - 1].x;
+    const int dy = path[i].y - path[i - 1].y;
+    ASSERT_TRUE(std::abs(dx) <= 1 && std::abs(dy) <= 1 && (dx != 0 || dy != 0));
+    if (dx != 0 && dy != 0){
+      // no cutting of corners
+      ASSERT_TRUE(isFree(map, path[i - 1].x + dx, path[i - 1].y));
+      ASSERT_TRUE(isFree(map, path[i - 1].x, path[i - 1].y + dy));
+      path_cost += M_SQRT2;
+    } else {
+      path_cost += 1.0;
+    }
+  }
+  EXPECT_NEAR(cost, path_cost, 1e-6);
+}
+}
+
+
+TEST(GridPlanner2D, matchesDijkstraOnRandomGrids){
+  for (unsigned int seed = 1; seed <= 20; ++seed){
+    const cv::Mat map = randomMap(40 + seed, 60 - seed, 0.05 * (seed % 8), seed);
+    GridPlanner2D planner;
+    planner.setMap(map);
+
+    for (int query = 0; query < 10; ++query){
+      const cv::Point start = randomFreeCell(map);
+      const cv::Point goal = randomFreeCell(map);
+      const double expected = dijkstra(map, start)[goal.x * map.cols + goal.y];
+
+      std::vector<cv::Point> path;
+      double cost;
+      const bool success = planner.plan(start, goal, path, cost);
+      EXPECT_EQ(expected >= 0.0, planner.isReachable(start, goal)) << "seed " << seed;
+      ASSERT_EQ(expected >= 0.0, success) << "seed " << seed;
+      if (!success)
+        continue;
+
+      EXPECT_NEAR(expected, cost, 1e-6) << "seed " << seed;
+      checkPath(map, start, goal, path, cost);
+    }
+  }
+}
+
+TEST(GridPlanner2D, doesNotCutCorners){
+  // free cells only connected diagonally through the corner of two obstacles
+  cv::Mat map(3, 3, CV_8UC1, cv::Scalar(FREE));
+  map.at<uchar>(0, 1) = OCCUPIED;
+  map.at<uchar>(1, 0) = OCCUPIED;
+  GridPlanner2D planner;
+  planner.setMap(map);
+
+  std::vector<cv::Point> path;
+  double cost;
+  EXPECT_FALSE(planner.isReachable(cv::Point(0, 0), cv::Point(1, 1)));
+  EXPECT_FALSE(planner.plan(cv::Point(0, 0), cv::Point(1, 1), path, cost));
+
+  // one obstacle beside the diagonal: around it with two straight moves
+  map.at<uchar>(1, 0) = FREE;
+  planner.setMap(map);
+  ASSERT_TRUE(planner.plan(cv::Point(0, 0), cv::Point(1, 1), path, cost));
+  EXPECT_NEAR(2.0, cost, 1e-6);
+  checkPath(map, cv::Point(0, 0), cv::Point(1, 1), path, cost);
+
+  // diagonal gaps in random walls of single cells
+  for (unsigned int seed = 1; seed <= 10; ++seed){
+    srand(seed);
+    cv::Mat diagonal_map(30, 30, CV_8UC1, cv::Scalar(FREE));
+    for (int i = 0; i < 60; ++i){
+      const int mx = rand() % 29;
+      const int my = rand() % 29;
+      diagonal_map.at<uchar>(mx, my + 1) = OCCUPIED;
+      diagonal_map.at<uchar>(mx + 1, my) = OCCUPIED;
+    }
+    planner.setMap(diagonal_map);
+    for (int query = 0; query < 10; ++query){
+      const cv::Point start = randomFreeCell(diagonal_map);
+      const cv::Point goal = randomFreeCell(diagonal_map);
+      const double expected = dijkstra(diagonal_map, start)[goal.x * diagonal_map.cols + goal.y];
+      ASSERT_EQ(expected >= 0.0, planner.plan(start, goal, path, cost)) << "seed " << seed;
+      if (expected >= 0.0){
+        EXPECT_NEAR(expected, cost, 1e-6) << "seed " << seed;
+        checkPath(diagonal_map, start, goal, path, cost);
+      }
+    }
+  }
+}
+
+TEST(GridPlanner2D, planBatchMatchesPlan){
+  const cv::Mat map = randomMap(50, 50, 0.25, 42);
+  GridPlanner2D planner;
+  planner.setMap(map);
+
+  std::vector<GridPlanner2D::Query> queries;
+  for (int i = 0; i < 50; ++i)
+    queries.push_back(GridPlanner2D::Query(randomFreeCell(map), randomFreeCell(map)));
+  // outside of the map
+  queries.push_back(GridPlanner2D::Query(cv::Point(-1, -1), cv::Point(0, 0)));
+
+  std::vector<GridPlanner2D::Result> results;
+  planner.planBatch(queries, results);
+  ASSERT_EQ(queries.size(), results.size());
+  for (size_t i = 0; i < queries.size(); ++i){
+    std::vector<cv::Point> path;
+    double cost;
+    ASSERT_EQ(planner.plan(queries[i].start, queries[i].goal, path, cost), results[i].success);
+    if (results[i].success)
+      EXPECT_NEAR(cost, results[i].cost, 1e-6);
+  }
+}
+
+TEST(GridPlanner2D, distanceMatrixMatchesPlan){
+  const cv::Mat map = randomMap(40, 30, 0.3, 7);
+  // padded grid of 42 x 32 cells, 4 bytes each per field
+  const size_t field_bytes = 42 * 32 * sizeof(float);
+
+  std::vector<cv::Point> sources, targets;
+  for (int i = 0; i < 12; ++i)
+    sources.push_back(randomFreeCell(map));
+  sources.push_back(sources.front());  // duplicate
+  sources.push_back(cv::Point(-1, -1)); // outside of the map
+  for (int mx = 0; mx < map.rows && sources.size() < 15; ++mx){
+    if (!isFree(map, mx, 0))
+      sources.push_back(cv::Point(mx, 0)); // occupied
+  }
+  for (int j = 0; j < 15; ++j)
+    targets.push_back(randomFreeCell(map));
+  targets.push_back(cv::Point(map.rows, 0)); // outside of the map
+
+  // no cache, cache smaller than a field, a few fields and all fields
+  const size_t cache_sizes[4] = {0, field_bytes / 2, 3 * field_bytes, 100 * field_bytes};
+  for (int c = 0; c < 4; ++c){
+    GridPlanner2D planner;
+    planner.setDistanceFieldCacheSize(cache_sizes[c]);
+    planner.setMap(map);
+
+    // the second round is (partly) answered from the cache
+    for (int round = 0; round < 2; ++round){
+      std::vector<double> distances;
+      planner.distanceMatrix(sources, targets, distances);
+      ASSERT_EQ(sources.size() * targets.size(), distances.size());
+      for (size_t i = 0; i < sources.size(); ++i){
+        for (size_t j = 0; j < targets.size(); ++j){
+          std::vector<cv::Point> path;
+          double cost;
+          const double distance = distances[i * targets.size() + j];
+          if (planner.plan(sources[i], targets[j], path, cost))
+            EXPECT_NEAR(cost, distance, 1e-3) << "cache " << cache_sizes[c] << ", source " << i << ", target " << j;
+          else
+            EXPECT_EQ(-1.0, distance) << "cache " << cache_sizes[c] << ", source " << i << ", target " << j;
+        }
+      }
+    }
+  }
+}
+
+/// exposes the distance field cache
+class CacheInspector : public GridPlanner2D {
+public:
+  size_t numCachedFields() const {return distance_fields_.size();}
+  size_t cachedBytes() const {return distance_fields_bytes_;}
+};
+
+TEST(GridPlanner2D, distanceFieldsAreEvictedAndReset){
+  const cv::Mat map = randomMap(30, 30, 0.1, 3);
+  const size_t field_bytes = 32 * 32 * sizeof(float);
+  CacheInspector planner;
+  planner.setDistanceFieldCacheSize(2 * field_bytes);
+  planner.setMap(map);
+
+  std::vector<cv::Point> sources, targets(1, randomFreeCell(map));
+  while (sources.size() < 5){
+    const cv::Point source = randomFreeCell(map);
+    if (std::find(sources.begin(), sources.end(), source) == sources.end())
+      sources.push_back(source);
+  }
+  std::vector<double> first, second;
+  planner.distanceMatrix(sources, targets, first);
+  EXPECT_EQ(2u, planner.numCachedFields());
+  EXPECT_EQ(2 * field_bytes, planner.cachedBytes());
+  planner.distanceMatrix(sources, targets, second);
+  EXPECT_EQ(first, second);
+
+  // shrinking the cache evicts
+  planner.setDistanceFieldCacheSize(field_bytes);
+  EXPECT_EQ(1u, planner.numCachedFields());
+  planner.setDistanceFieldCacheSize(0);
+  EXPECT_EQ(0u, planner.numCachedFields());
+  planner.distanceMatrix(sources, targets, second);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(0u, planner.cachedBytes());
+
+  // a new map drops all fields
+  planner.setDistanceFieldCacheSize(GridPlanner2D::DEFAULT_DISTANCE_FIELD_CACHE_SIZE);
+  planner.distanceMatrix(sources, targets, second);
+  EXPECT_EQ(sources.size(), planner.numCachedFields());
+  cv::Mat blocked(map.rows, map.cols, CV_8UC1, cv::Scalar(OCCUPIED));
+  planner.setMap(blocked);
+  EXPECT_EQ(0u, planner.numCachedFields());
+  planner.distanceMatrix(sources, targets, second);
+  EXPECT_EQ(std::vector<double>(sources.size(), -1.0), second);
+}
+
+int main(int argc, char** argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
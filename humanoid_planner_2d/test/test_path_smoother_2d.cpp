@@ -0,0 +1,178 @@
+/*
+ * Copyright 2013 Armin Hornung, University of Freiburg
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <humanoid_planner_2d/GridPlanner2D.h>
+#include <humanoid_planner_2d/PathSmoother2D.h>
+#include <gridmap_2d/GridMap2D.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+const uchar FREE = gridmap_2d::GridMap2D::FREE;
+const uchar OCCUPIED = gridmap_2d::GridMap2D::OCCUPIED;
+
+/// inflated map (rows: mx, cols: my) with random rectangular obstacles
+cv::Mat randomMap(int width, int height, int num_obstacles, unsigned int seed){
+  srand(seed);
+  cv::Mat map(width, height, CV_8UC1, cv::Scalar(FREE));
+  for (int i = 0; i < num_obstacles; ++i){
+    const int mx = rand() % width;
+    const int my = rand() % height;
+    const int size_x = 1 + rand() % 8;
+    const int size_y = 1 + rand() % 8;
+    for (int x = mx; x < std::min(mx + size_x, width); ++x){
+      for (int y = my; y < std::min(my + size_y, height); ++y)
+        map.at<uchar>(x, y) = OCCUPIED;
+    }
+  }
+  return map;
+}
+
+bool isFree(const cv::Mat& map, int mx, int my){
+  return mx >= 0 && my >= 0 && mx < map.rows && my < map.cols && map.at<uchar>(mx, my) != OCCUPIED;
+}
+
+cv::Point randomFreeCell(const cv::Mat& map){
+  while (true){
+    const cv::Point cell(rand() % map.rows, rand() % map.cols);
+    if (isFree(map, cell.x, cell.y))
+      return cell;
+  }
+}
+
+/// true if all densely sampled points of the polyline lie in free cells
+bool polylineFree(const cv::Mat& map, const std::vector<cv::Point2d>& waypoints){
+  for (size_t i = 1; i < waypoints.size(); ++i){
+    const cv::Point2d d = waypoints[i] - waypoints[i - 1];
+    const int num_samples = 1 + int(100.0 * std::sqrt(d.dot(d)));
+    for (int k = 0; k <= num_samples; ++k){
+      const cv::Point2d p = waypoints[i - 1] + d * (double(k) / num_samples);
+      if (!isFree(map, int(std::floor(p.x)), int(std::floor(p.y))))
+        return false;
+    }
+  }
+  return true;
+}
+
+/// radius of the circle through a, b and c (infinite if they are collinear)
+double circumradius(const cv::Point2d& a, const cv::Point2d& b, const cv::Point2d& c){
+  const cv::Point2d ab = b - a;
+  const cv::Point2d bc = c - b;
+  const cv::Point2d ca = a - c;
+  const double cross = std::abs(ab.x * bc.y - ab.y * bc.x);
+  if (cross < 1e-12)
+    return HUGE_VAL;
+  return std::sqrt(ab.dot(ab) * bc.dot(bc) * ca.dot(ca)) / (2.0 * cross);
+}
+}
+
+
+TEST(PathSmoother2D, staysFreeAndKeepsTheTurningRadius){
+  const double turning_radii[4] = {0.0, 1.0, 3.0, 8.0};
+  int num_arcs = 0;
+  for (unsigned int seed = 1; seed <= 20; ++seed){
+    const cv::Mat map = randomMap(60, 60, 10 + 4 * seed, seed);
+    GridPlanner2D planner;
+    planner.setMap(map);
+    PathSmoother2D smoother;
+    smoother.setMap(map);
+
+    for (int query = 0; query < 10; ++query){
+      std::vector<cv::Point> cells;
+      double cost;
+      if (!planner.plan(randomFreeCell(map), randomFreeCell(map), cells, cost))
+        continue;
+
+      std::vector<cv::Point2d> corners;
+      smoother.shortcut(cells, corners);
+      ASSERT_TRUE(polylineFree(map, corners)) << "seed " << seed;
+      EXPECT_LE(PathSmoother2D::length(corners), cost + 1e-6) << "seed " << seed;
+
+      for (int r = 0; r < 4; ++r){
+        smoother.setTurningRadius(turning_radii[r]);
+        std::vector<cv::Point2d> waypoints = corners;
+        smoother.smooth(waypoints);
+        ASSERT_TRUE(polylineFree(map, waypoints)) << "seed " << seed << ", radius " << turning_radii[r];
+        ASSERT_FALSE(waypoints.empty());
+        EXPECT_EQ(corners.front(), waypoints.front());
+        EXPECT_EQ(corners.back(), waypoints.back());
+        if (turning_radii[r] <= 0.0){
+          EXPECT_EQ(corners.size(), waypoints.size());
+          continue;
+        }
+
+        // all turns except the kept corners follow circles of at least the
+        // turning radius
+        for (size_t i = 1; i + 1 < waypoints.size(); ++i){
+          if (std::find(corners.begin(), corners.end(), waypoints[i]) != corners.end())
+            continue;
+          ++num_arcs;
+          EXPECT_GE(circumradius(waypoints[i - 1], waypoints[i], waypoints[i + 1]), turning_radii[r] * (1.0 - 1e-6))
+            << "seed " << seed << ", radius " << turning_radii[r] << ", waypoint " << i;
+        }
+      }
+    }
+  }
+  // the arcs have actually been checked
+  EXPECT_GT(num_arcs, 100);
+}
+
+TEST(PathSmoother2D, keepsCornersWithoutSpace){
+  PathSmoother2D smoother;
+  smoother.setMap(cv::Mat(20, 20, CV_8UC1, cv::Scalar(FREE)));
+
+  // 2 cells long legs do not fit a radius of 5 cells around a right angle
+  std::vector<cv::Point2d> waypoints;
+  waypoints.push_back(cv::Point2d(5.5, 5.5));
+  waypoints.push_back(cv::Point2d(7.5, 5.5));
+  waypoints.push_back(cv::Point2d(7.5, 7.5));
+  const std::vector<cv::Point2d> corners = waypoints;
+  smoother.setTurningRadius(5.0);
+  smoother.smooth(waypoints);
+  EXPECT_EQ(corners, waypoints);
+
+  // with long enough legs, the arc has exactly the turning radius
+  waypoints[1] = cv::Point2d(15.5, 5.5);
+  waypoints[2] = cv::Point2d(15.5, 15.5);
+  smoother.smooth(waypoints);
+  ASSERT_GT(waypoints.size(), 4u);
+  for (size_t i = 1; i + 1 < waypoints.size(); ++i){
+    const cv::Point2d d = waypoints[i] - cv::Point2d(10.5, 10.5);
+    EXPECT_NEAR(5.0, std::sqrt(d.dot(d)), 1e-6);
+  }
+}
+
+int main(int argc, char** argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}